@@ -56,13 +56,15 @@ bool H264Source::HandleFrame(MediaChannelId channel_id, AVFrame frame)
 	    frame.timestamp = GetTimestamp();
     }    
 
+    // 负载直接引用帧内存 (与 frame.buffer 共享引用计数), 发送时与 RTP 头聚合, 不拷贝
     if (frame_size <= MAX_RTP_PAYLOAD_SIZE) {
         RtpPacket rtp_pkt;
 	    rtp_pkt.type = frame.type;
 	    rtp_pkt.timestamp = frame.timestamp;
-	    rtp_pkt.size = frame_size + RTP_TCP_HEAD_SIZE + RTP_HEADER_SIZE;
+	    rtp_pkt.size = RTP_TCP_HEAD_SIZE + RTP_HEADER_SIZE;
 	    rtp_pkt.last = 1;
-        memcpy(rtp_pkt.data.get()+RTP_TCP_HEAD_SIZE+RTP_HEADER_SIZE, frame_buf, frame_size);
+        rtp_pkt.payload = frame.buffer;
+        rtp_pkt.payload_size = frame_size;
 
         if (send_frame_callback_) {
 		    if (!send_frame_callback_(channel_id, rtp_pkt)) {
@@ -83,12 +85,13 @@ bool H264Source::HandleFrame(MediaChannelId channel_id, AVFrame frame)
             RtpPacket rtp_pkt;
             rtp_pkt.type = frame.type;
             rtp_pkt.timestamp = frame.timestamp;
-            rtp_pkt.size = RTP_TCP_HEAD_SIZE + RTP_HEADER_SIZE + MAX_RTP_PAYLOAD_SIZE;
+            rtp_pkt.size = RTP_TCP_HEAD_SIZE + RTP_HEADER_SIZE + 2;
             rtp_pkt.last = 0;
 
             rtp_pkt.data.get()[RTP_TCP_HEAD_SIZE + RTP_HEADER_SIZE + 0] = FU_A[0];
             rtp_pkt.data.get()[RTP_TCP_HEAD_SIZE + RTP_HEADER_SIZE + 1] = FU_A[1];
-            memcpy(rtp_pkt.data.get()+RTP_TCP_HEAD_SIZE+RTP_HEADER_SIZE+2, frame_buf, MAX_RTP_PAYLOAD_SIZE-2);
+            rtp_pkt.payload = std::shared_ptr<uint8_t>(frame.buffer, frame_buf);
+            rtp_pkt.payload_size = MAX_RTP_PAYLOAD_SIZE - 2;
 
             if (send_frame_callback_) {
                 if (!send_frame_callback_(channel_id, rtp_pkt))
@@ -105,13 +108,14 @@ bool H264Source::HandleFrame(MediaChannelId channel_id, AVFrame frame)
             RtpPacket rtp_pkt;
             rtp_pkt.type = frame.type;
             rtp_pkt.timestamp = frame.timestamp;
-            rtp_pkt.size = 4 + RTP_HEADER_SIZE + 2 + frame_size;
+            rtp_pkt.size = 4 + RTP_HEADER_SIZE + 2;
             rtp_pkt.last = 1;
 
             FU_A[1] |= 0x40;
             rtp_pkt.data.get()[RTP_TCP_HEAD_SIZE + RTP_HEADER_SIZE + 0] = FU_A[0];
             rtp_pkt.data.get()[RTP_TCP_HEAD_SIZE + RTP_HEADER_SIZE + 1] = FU_A[1];
-            memcpy(rtp_pkt.data.get()+RTP_TCP_HEAD_SIZE+RTP_HEADER_SIZE+2, frame_buf, frame_size);
+            rtp_pkt.payload = std::shared_ptr<uint8_t>(frame.buffer, frame_buf);
+            rtp_pkt.payload_size = frame_size;
 
             if (send_frame_callback_) {
 			    if (!send_frame_callback_(channel_id, rtp_pkt)) {
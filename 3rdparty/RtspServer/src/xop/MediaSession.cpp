@@ -50,6 +50,18 @@ void MediaSession::AddNotifyDisconnectedCallback(const NotifyDisconnectedCallbac
 	notify_disconnected_callbacks_.push_back(callback);
 }
 
+void MediaSession::AddNotifyReceiverReportCallback(const NotifyReceiverReportCallback& callback)
+{
+	notify_receiver_report_callbacks_.push_back(callback);
+}
+
+void MediaSession::NotifyReceiverReport(const RtcpReceiverReport& report)
+{
+	for (auto& callback : notify_receiver_report_callbacks_) {
+		callback(session_id_, report);
+	}
+}
+
 bool MediaSession::AddSource(MediaChannelId channel_id, MediaSource* source)
 {
 	source->SetSendFrameCallback([this](MediaChannelId channel_id, RtpPacket pkt) {
@@ -72,6 +84,8 @@ bool MediaSession::AddSource(MediaChannelId channel_id, MediaSource* source)
 							tmp_pkt.last = pkt.last;
 							tmp_pkt.timestamp = pkt.timestamp;
 							tmp_pkt.type = pkt.type;
+							tmp_pkt.payload = pkt.payload;
+							tmp_pkt.payload_size = pkt.payload_size;
 							packets.emplace(id, tmp_pkt);
 						}
 						clients.emplace_front(conn);
@@ -33,6 +33,7 @@ public:
 	using Ptr = std::shared_ptr<MediaSession>;
 	using NotifyConnectedCallback = std::function<void (MediaSessionId sessionId, std::string peer_ip, uint16_t peer_port)> ;
 	using NotifyDisconnectedCallback = std::function<void (MediaSessionId sessionId, std::string peer_ip, uint16_t peer_port)> ;
+	using NotifyReceiverReportCallback = std::function<void (MediaSessionId sessionId, const RtcpReceiverReport& report)> ;
 
 	static MediaSession* CreateNew(std::string url_suffix="live");
 	virtual ~MediaSession();
@@ -44,6 +45,10 @@ public:
 
 	void AddNotifyConnectedCallback(const NotifyConnectedCallback& callback);
 	void AddNotifyDisconnectedCallback(const NotifyDisconnectedCallback& callback);
+	void AddNotifyReceiverReportCallback(const NotifyReceiverReportCallback& callback);
+
+	/* 客户端发来的 RTCP 接收者报告, 在 RTSP 事件循环线程中调用 */
+	void NotifyReceiverReport(const RtcpReceiverReport& report);
 
 	std::string GetRtspUrlSuffix() const
 	{ return suffix_; }
@@ -94,6 +99,7 @@ private:
 
 	std::vector<NotifyConnectedCallback> notify_connected_callbacks_;
 	std::vector<NotifyDisconnectedCallback> notify_disconnected_callbacks_;
+	std::vector<NotifyReceiverReportCallback> notify_receiver_report_callbacks_;
 	std::mutex mutex_;
 	std::mutex map_mutex_;
 	std::map<SOCKET, std::weak_ptr<RtpConnection>> clients_;
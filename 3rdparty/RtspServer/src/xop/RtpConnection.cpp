@@ -272,20 +272,57 @@ int RtpConnection::SendRtpOverTcp(MediaChannelId channel_id, RtpPacket pkt)
 		return -1;
 	}
 
+	uint32_t total = pkt.size + pkt.payload_size;
 	uint8_t* rtpPktPtr = pkt.data.get();
 	rtpPktPtr[0] = '$';
 	rtpPktPtr[1] = (char)media_channel_info_[channel_id].rtp_channel;
-	rtpPktPtr[2] = (char)(((pkt.size-4)&0xFF00)>>8);
-	rtpPktPtr[3] = (char)((pkt.size -4)&0xFF);
+	rtpPktPtr[2] = (char)(((total-4)&0xFF00)>>8);
+	rtpPktPtr[3] = (char)((total -4)&0xFF);
 
-	conn->Send((char*)rtpPktPtr, pkt.size);
-	return pkt.size;
+	if (pkt.payload_size == 0) {
+		conn->Send((char*)rtpPktPtr, pkt.size);
+		return pkt.size;
+	}
+
+	// 写缓冲需要保存到 socket 可写为止, 头和外部负载在这里拼接 (负载唯一的一次拷贝)
+	std::shared_ptr<char> buf(new char[total], std::default_delete<char[]>());
+	memcpy(buf.get(), rtpPktPtr, pkt.size);
+	memcpy(buf.get() + pkt.size, pkt.payload.get(), pkt.payload_size);
+	conn->Send(buf, total);
+	return total;
 }
 
 int RtpConnection::SendRtpOverUdp(MediaChannelId channel_id, RtpPacket pkt)
 {
-	int ret = sendto(rtpfd_[channel_id], (const char*)pkt.data.get()+4, pkt.size-4, 0,
+	int ret = 0;
+	if (pkt.payload_size == 0) {
+		ret = sendto(rtpfd_[channel_id], (const char*)pkt.data.get()+4, pkt.size-4, 0,
 					(struct sockaddr *)&(peer_rtp_addr_[channel_id]), sizeof(struct sockaddr_in));
+	}
+	else {
+#if defined(__linux) || defined(__linux__)
+		// RTP 头和外部负载用 sendmsg 聚合发送, 负载不经过拷贝
+		struct iovec iov[2];
+		iov[0].iov_base = pkt.data.get() + 4;
+		iov[0].iov_len = pkt.size - 4;
+		iov[1].iov_base = pkt.payload.get();
+		iov[1].iov_len = pkt.payload_size;
+
+		struct msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_name = &(peer_rtp_addr_[channel_id]);
+		msg.msg_namelen = sizeof(struct sockaddr_in);
+		msg.msg_iov = iov;
+		msg.msg_iovlen = 2;
+		ret = sendmsg(rtpfd_[channel_id], &msg, 0);
+#else
+		std::shared_ptr<uint8_t> buf(new uint8_t[pkt.size + pkt.payload_size], std::default_delete<uint8_t[]>());
+		memcpy(buf.get(), pkt.data.get(), pkt.size);
+		memcpy(buf.get() + pkt.size, pkt.payload.get(), pkt.payload_size);
+		ret = sendto(rtpfd_[channel_id], (const char*)buf.get()+4, pkt.size + pkt.payload_size - 4, 0,
+					(struct sockaddr *)&(peer_rtp_addr_[channel_id]), sizeof(struct sockaddr_in));
+#endif
+	}
                    
 	if(ret < 0) {        
 		Teardown();
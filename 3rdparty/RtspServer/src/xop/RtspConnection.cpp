@@ -207,7 +207,10 @@ void RtspConnection::HandleRtcp(BufferReader& buffer)
 {    
 	char *peek = buffer.Peek();
 	if(peek[0] == '$' &&  buffer.ReadableBytes() > 4) {
-		uint32_t pkt_size = peek[2]<<8 | peek[3];
+		uint32_t pkt_size = (uint8_t)peek[2]<<8 | (uint8_t)peek[3];
+		if(pkt_size + 4 <= buffer.ReadableBytes()) {
+			HandleRtcpPacket((const uint8_t*)peek + 4, pkt_size);
+		}
 		if(pkt_size +4 >=  buffer.ReadableBytes()) {
 			buffer.Retrieve(pkt_size +4);  
 		}
@@ -217,8 +220,52 @@ void RtspConnection::HandleRtcp(BufferReader& buffer)
 void RtspConnection::HandleRtcp(SOCKET sockfd)
 {
 	char buf[1024] = {0};
-	if(recv(sockfd, buf, 1024, 0) > 0) {
+	int size = recv(sockfd, buf, 1024, 0);
+	if(size > 0) {
 		KeepAlive();
+		HandleRtcpPacket((const uint8_t*)buf, size);
+	}
+}
+
+/* 解析复合 RTCP 包中 SR/RR 的报告块, 交给会话的接收者报告回调 */
+void RtspConnection::HandleRtcpPacket(const uint8_t* data, uint32_t size)
+{
+	auto rtsp = rtsp_.lock();
+	if (!rtsp || session_id_ == 0) {
+		return;
+	}
+	MediaSession::Ptr media_session = rtsp->LookMediaSession(session_id_);
+	if (!media_session) {
+		return;
+	}
+
+	while (size >= 8 && (data[0] >> 6) == 2) {
+		uint32_t pkt_size = ((data[2] << 8 | data[3]) + 1) * 4;
+		if (pkt_size > size) {
+			break;
+		}
+
+		uint8_t type = data[1];
+		uint32_t count = data[0] & 0x1f;
+		uint32_t offset = 8;            /* 头部 + 发送者 SSRC */
+		if (type == 200) {
+			offset += 20;               /* SR 的发送者信息 */
+		}
+		if (type == 200 || type == 201) {
+			for (uint32_t i = 0; i < count && offset + 24 <= pkt_size; i++, offset += 24) {
+				const uint8_t* block = data + offset;
+				RtcpReceiverReport report;
+				report.ssrc = (uint32_t)block[0] << 24 | block[1] << 16 | block[2] << 8 | block[3];
+				report.fraction_lost = block[4];
+				report.cumulative_lost = (int32_t)((uint32_t)block[5] << 24 | block[6] << 16 | block[7] << 8) >> 8;
+				report.highest_seq = (uint32_t)block[8] << 24 | block[9] << 16 | block[10] << 8 | block[11];
+				report.jitter = (uint32_t)block[12] << 24 | block[13] << 16 | block[14] << 8 | block[15];
+				media_session->NotifyReceiverReport(report);
+			}
+		}
+
+		data += pkt_size;
+		size -= pkt_size;
 	}
 }
 
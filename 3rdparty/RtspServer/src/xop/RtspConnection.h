@@ -91,6 +91,7 @@ private:
 	void OnClose();
 	void HandleRtcp(SOCKET sockfd);
 	void HandleRtcp(BufferReader& buffer);   
+	void HandleRtcpPacket(const uint8_t* data, uint32_t size);
 	bool HandleRtspRequest(BufferReader& buffer);
 	bool HandleRtspResponse(BufferReader& buffer);
 
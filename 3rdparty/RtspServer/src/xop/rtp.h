@@ -82,6 +82,7 @@ struct RtpPacket
 		size = 0;
 		timestamp = 0;
 		last = 0;
+		payload_size = 0;
 	}
 
 	std::shared_ptr<uint8_t> data;
@@ -89,6 +90,20 @@ struct RtpPacket
 	uint32_t timestamp;
 	uint8_t  type;
 	uint8_t  last;
+
+	/* 外部负载: 紧跟在 data 的 size 字节之后发送, 直接引用帧内存, 不拷贝 */
+	std::shared_ptr<uint8_t> payload;
+	uint32_t payload_size;
+};
+
+/* RTCP 接收者报告 (SR/RR 中的报告块) */
+struct RtcpReceiverReport
+{
+	uint32_t ssrc;              /* 被报告的 RTP 源 */
+	uint8_t  fraction_lost;     /* 上一报告周期的丢包率 * 256 */
+	int32_t  cumulative_lost;   /* 累计丢包数 */
+	uint32_t highest_seq;       /* 扩展的最高接收序号 */
+	uint32_t jitter;            /* 到达间隔抖动 (RTP 时间戳单位) */
 };
 
 }
@@ -0,0 +1,260 @@
+/*
+    后处理评测工具：回放录制的原始输出张量，统计 decode+NMS 的逐帧耗时分位数，并与 golden 结果比对。
+    不依赖 NPU/RGA/MPP，可以在 x86 主机上编译运行。
+
+    用法:
+      postprocess_bench [--iters N] [--labels path] [--update-golden] <corpus_dir>...
+      postprocess_bench --synth <out_root>      生成 sparse/typical/crowded 三组合成语料 (YOLOv5 80 类, 640x640)
+
+    语料目录由 RKNNDetector::set_capture 录制，golden.txt 保存在语料目录下。
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "postprocess.h"
+#include "tensor_replay.h"
+#include "count_utils.h"
+
+struct BenchOptions {
+    int iters = 20;
+    bool update_golden = false;
+    std::string labels = LABEL_NALE_TXT_PATH;
+    std::vector<std::string> corpora;
+};
+
+static double percentile(std::vector<int64_t>& samples, double p){
+    if(samples.empty()) return 0.0;
+    std::sort(samples.begin(), samples.end());
+    size_t idx = (size_t)std::min((double)samples.size() - 1, floor(p * (samples.size() - 1) + 0.5));
+    return (double)samples[idx];
+}
+
+/**
+ * @brief  把一帧检测结果写成 golden 文本
+**/
+static void write_golden_frame(FILE* fp, int idx, const detect_result_group_t& g){
+    fprintf(fp, "frame %d %d\n", idx, g.count);
+    for(int i=0;i<g.count;i++){
+        const detect_result_t& r = g.results[i];
+        fprintf(fp, "%d %d %d %d %d %.6f\n", r.class_index, r.box.left, r.box.top, r.box.right, r.box.bottom, r.prop);
+    }
+}
+
+/**
+ * @brief  读取 golden 文本中的一帧并与当前结果比对 (框允许 1 像素误差，置信度允许 1e-3)
+ * @return 0 一致，-1 不一致或文件格式错误
+**/
+static int check_golden_frame(FILE* fp, int idx, const detect_result_group_t& g){
+    int gidx = -1, gcount = -1;
+    if(fscanf(fp, " frame %d %d", &gidx, &gcount) != 2 || gidx != idx){
+        printf("  golden: frame %d missing\n", idx);
+        return -1;
+    }
+    int ret = 0;
+    if(gcount != g.count){
+        printf("  golden: frame %d count %d, got %d\n", idx, gcount, g.count);
+        ret = -1;
+    }
+    for(int i=0;i<gcount;i++){
+        int cls, l, t, r, b;
+        float prop;
+        if(fscanf(fp, " %d %d %d %d %d %f", &cls, &l, &t, &r, &b, &prop) != 6){
+            printf("  golden: frame %d truncated\n", idx);
+            return -1;
+        }
+        if(ret < 0 || i >= g.count) continue;
+        const detect_result_t& d = g.results[i];
+        if(cls != d.class_index || abs(l - d.box.left) > 1 || abs(t - d.box.top) > 1 ||
+           abs(r - d.box.right) > 1 || abs(b - d.box.bottom) > 1 || fabsf(prop - d.prop) > 1e-3f){
+            printf("  golden: frame %d result %d differs: cls %d (%d %d %d %d) %.3f, got cls %d (%d %d %d %d) %.3f\n",
+                   idx, i, cls, l, t, r, b, prop, d.class_index, d.box.left, d.box.top, d.box.right,
+                   d.box.bottom, d.prop);
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief  评测一个语料目录
+ * @return 0 成功且与 golden 一致，-1 失败
+**/
+static int bench_corpus(const std::string& dir, const BenchOptions& opt){
+    TensorReplayer replayer;
+    if(replayer.open(dir) < 0) return -1;
+
+    post_process_ctx_t ctx;
+    if(init_post_process(&ctx, replayer.output_attrs(), replayer.output_count(), replayer.model_height(),
+                         replayer.model_width(), opt.labels.c_str()) < 0){
+        return -1;
+    }
+
+    BOX_RECT pads;
+    memset(&pads, 0, sizeof(pads));
+    std::vector<int8_t*> outputs(replayer.output_count());
+    std::vector<detect_result_group_t> results(replayer.frame_count());
+    std::vector<int64_t> samples;
+    int64_t total_dets = 0;
+
+    // 第一轮只用于预热缓存和临时缓冲区，不计时
+    for(int iter=0;iter<=opt.iters;iter++){
+        for(int f=0;f<replayer.frame_count();f++){
+            replayer.frame(f, outputs.data());
+            int64_t t0 = now_us();
+            post_process(&ctx, outputs.data(), replayer.model_height(), replayer.model_width(), pads, 1.0f, 1.0f,
+                         &results[f]);
+            int64_t t1 = now_us();
+            if(iter > 0){
+                samples.push_back(t1 - t0);
+                total_dets += results[f].count;
+            }
+        }
+    }
+
+    int64_t sum = 0;
+    for(int64_t s : samples) sum += s;
+    int n = (int)samples.size();
+    printf("[BENCH] %-24s frames=%4d dets/frame=%6.2f avg=%8.1f us p50=%8.1f us p90=%8.1f us p99=%8.1f us max=%8.1f us\n",
+           dir.c_str(), replayer.frame_count(), n ? (double)total_dets / n : 0.0, n ? (double)sum / n : 0.0,
+           percentile(samples, 0.50), percentile(samples, 0.90), percentile(samples, 0.99),
+           percentile(samples, 1.0));
+
+    int ret = 0;
+    std::string golden = dir + "/golden.txt";
+    if(opt.update_golden){
+        FILE* fp = fopen(golden.c_str(), "w");
+        if(fp == nullptr){
+            printf("  failed to write %s\n", golden.c_str());
+            ret = -1;
+        }
+        else{
+            for(int f=0;f<replayer.frame_count();f++) write_golden_frame(fp, f, results[f]);
+            fclose(fp);
+            printf("  golden updated: %s\n", golden.c_str());
+        }
+    }
+    else{
+        FILE* fp = fopen(golden.c_str(), "r");
+        if(fp == nullptr){
+            printf("  no golden file, skip check (run with --update-golden to create one)\n");
+        }
+        else{
+            for(int f=0;f<replayer.frame_count();f++){
+                if(check_golden_frame(fp, f, results[f]) < 0) ret = -1;
+            }
+            fclose(fp);
+            printf("  golden check: %s\n", ret == 0 ? "PASS" : "FAIL");
+        }
+    }
+
+    deinit_post_process(&ctx);
+    return ret;
+}
+
+/**
+ * @brief  生成一组合成语料：背景为低置信度噪声，随机放置 objects 个高置信度目标
+**/
+static int synth_corpus(const std::string& dir, int frames, int objects, unsigned seed){
+    const int model_w = 640, model_h = 640, class_num = 80, prop = 5 + class_num;
+    const int strides[3] = {8, 16, 32};
+    rknn_tensor_attr attrs[3];
+    memset(attrs, 0, sizeof(attrs));
+    for(int i=0;i<3;i++){
+        attrs[i].index = i;
+        attrs[i].fmt = RKNN_TENSOR_NCHW;
+        attrs[i].n_dims = 4;
+        attrs[i].dims[0] = 1;
+        attrs[i].dims[1] = 3 * prop;
+        attrs[i].dims[2] = model_h / strides[i];
+        attrs[i].dims[3] = model_w / strides[i];
+        attrs[i].n_elems = attrs[i].dims[1] * attrs[i].dims[2] * attrs[i].dims[3];
+        attrs[i].zp = -128;
+        attrs[i].scale = 1.0f / 255.0f;
+    }
+
+    TensorRecorder recorder;
+    if(recorder.open(dir, attrs, 3, model_w, model_h) < 0) return -1;
+
+    std::mt19937 rng(seed);
+    std::vector<std::vector<int8_t> > tensors(3);
+    for(int f=0;f<frames;f++){
+        for(int i=0;i<3;i++){
+            tensors[i].resize(attrs[i].n_elems);
+            for(auto& v : tensors[i]) v = (int8_t)(-128 + rng() % 48);
+        }
+        for(int k=0;k<objects;k++){
+            int b = rng() % 3;
+            int gh = attrs[b].dims[2], gw = attrs[b].dims[3], grid_len = gh * gw;
+            int a = rng() % 3, y = rng() % gh, x = rng() % gw;
+            int8_t* base = tensors[b].data() + (prop * a) * grid_len + y * gw + x;
+            for(int c=0;c<4;c++) base[c * grid_len] = (int8_t)(-128 + 64 + rng() % 128);
+            base[4 * grid_len] = (int8_t)(-128 + 200 + rng() % 55);
+            base[(5 + rng() % class_num) * grid_len] = (int8_t)(-128 + 180 + rng() % 75);
+        }
+        int8_t* outs[3] = {tensors[0].data(), tensors[1].data(), tensors[2].data()};
+        if(recorder.write(outs) < 0) return -1;
+    }
+    return 0;
+}
+
+static int synth_all(const std::string& root){
+    if(mkdir(root.c_str(), 0755) < 0 && errno != EEXIST){
+        perror("mkdir synth root failed");
+        return -1;
+    }
+    if(synth_corpus(root + "/sparse", 60, 2, 1) < 0) return -1;
+    if(synth_corpus(root + "/typical", 60, 12, 2) < 0) return -1;
+    if(synth_corpus(root + "/crowded", 60, 80, 3) < 0) return -1;
+    printf("Synthetic corpora written to %s/{sparse,typical,crowded}\n", root.c_str());
+    return 0;
+}
+
+static void usage(const char* prog){
+    printf("usage: %s [--iters N] [--labels path] [--update-golden] <corpus_dir>...\n", prog);
+    printf("       %s --synth <out_root>\n", prog);
+}
+
+int main(int argc, char* argv[]){
+    BenchOptions opt;
+    for(int i=1;i<argc;i++){
+        std::string arg = argv[i];
+        if(arg == "--iters" && i + 1 < argc){
+            opt.iters = std::max(1, atoi(argv[++i]));
+        }
+        else if(arg == "--labels" && i + 1 < argc){
+            opt.labels = argv[++i];
+        }
+        else if(arg == "--update-golden"){
+            opt.update_golden = true;
+        }
+        else if(arg == "--synth" && i + 1 < argc){
+            return synth_all(argv[++i]) == 0 ? 0 : 1;
+        }
+        else if(arg[0] == '-'){
+            usage(argv[0]);
+            return 1;
+        }
+        else{
+            opt.corpora.push_back(arg);
+        }
+    }
+    if(opt.corpora.empty()){
+        usage(argv[0]);
+        return 1;
+    }
+
+    int failed = 0;
+    for(const auto& dir : opt.corpora){
+        if(bench_corpus(dir, opt) < 0) failed++;
+    }
+    return failed ? 1 : 0;
+}
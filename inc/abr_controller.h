@@ -0,0 +1,96 @@
+#ifndef ABR_CONTROLLER_H
+#define ABR_CONTROLLER_H
+
+#include <stdint.h>
+#include <mutex>
+
+/*
+    码率自适应 (ABR)：根据网络反馈闭环调整编码码率、帧率和分辨率，链路拥塞时让排队时延保持有界。
+    反馈信号 (任意线程上报，每个评估周期汇总一次):
+    - 发送端：每帧的发送耗时 (阻塞在发送缓冲区上的时间)、发送失败、socket 发送队列占用率
+    - 接收端：RTCP 接收者报告的丢包率和抖动，或接收端自定义的反馈消息
+    调整顺序：
+    - 拥塞：码率乘性下降；码率已到下限且仍持续拥塞时先降帧率，最后才降分辨率
+    - 空闲：连续 up_hold 个周期没有拥塞才恢复一步，按分辨率、帧率、码率的顺序逆向恢复，码率加性上升
+    拥塞和空闲的阈值之间留有间隔，介于两者之间时保持不变，避免来回抖动。
+    丢帧后需要 IDR 修复画面，但拥塞期间每个周期都发 IDR 会让链路更拥塞，因此 IDR 请求按 idr_hold 限频。
+*/
+
+struct AbrConfig {
+    int bps_min = 500000;               // 码率下限 (bit/s)
+    int bps_max = 2500000;              // 码率上限，也是初始码率
+    float decrease = 0.7f;              // 拥塞时码率乘以该系数
+    float increase = 0.1f;              // 空闲时码率增加 bps_max 的该比例
+    int interval_ms = 500;              // 评估周期
+    float queue_high = 0.5f;            // 发送队列占用率高于该值视为拥塞
+    float queue_low = 0.15f;            // 低于该值视为空闲
+    float busy_high = 0.6f;             // 周期内阻塞在发送上的时间占比高于该值视为拥塞
+    float busy_low = 0.3f;
+    float loss_high = 0.05f;            // 接收端丢包率高于该值视为拥塞
+    float loss_low = 0.01f;
+    float jitter_high_ms = 30.0f;       // 接收端抖动高于该值视为拥塞 (排队时延在变化)
+    float jitter_low_ms = 10.0f;
+    int up_hold = 4;                    // 连续多少个空闲周期后恢复一步
+    int degrade_hold = 3;               // 码率到下限后仍连续拥塞多少个周期才降帧率/分辨率
+    int max_fps_divisor = 3;            // 最多降到 1/3 帧率
+    int max_scale_level = 2;            // 分辨率档位：0 原始，1 为 3/4，2 为 1/2
+    int idr_hold = 6;                   // 两次 IDR 请求之间至少间隔多少个周期，期间的丢帧合并到下一次 IDR
+};
+
+// 当前的编码目标
+struct AbrState {
+    int bps;
+    int fps_divisor;                    // 每 fps_divisor 帧编码一帧
+    int scale_level;                    // 分辨率档位
+    bool need_idr;                      // 发生过丢帧 (接收端画面已损坏)，需要尽快发一个 IDR
+};
+
+class AbrController {
+public:
+    explicit AbrController(const AbrConfig& cfg = AbrConfig());
+
+    // 一帧发送完成：send_us 为发送耗时，failed 表示有分片发送失败，queue_ratio 为发送后的队列占用率 (未知时传 0)
+    void on_send(int64_t send_us, bool failed, float queue_ratio);
+
+    // 接收端反馈：loss 为丢包率 (0~1)，jitter_ms 为抖动
+    void on_receiver_report(float loss, float jitter_ms);
+
+    /**
+     * 每帧调用一次，到达评估周期时根据汇总的反馈调整编码目标
+     * 返回 true 表示目标有变化 (码率、帧率、分辨率或需要 IDR)，state 为新的目标
+     */
+    bool update(int64_t now_us, AbrState& state);
+
+    // 分辨率档位对应的缩放比例
+    static float scale_of(int level);
+
+    AbrState current() const;
+    float last_loss() const;
+    float last_queue() const;
+    float last_jitter_ms() const;
+
+private:
+    AbrConfig cfg;
+    AbrState state;
+    mutable std::mutex mtx;
+
+    // 当前周期的反馈汇总
+    int64_t period_start;
+    int64_t busy_us;
+    int failures;
+    float max_queue;
+    float loss;
+    float jitter_ms;
+
+    // 上一周期的汇总 (供统计输出)
+    float prev_loss;
+    float prev_queue;
+    float prev_jitter_ms;
+
+    int up_count;
+    int down_count;
+    int since_idr;                      // 距上次请求 IDR 的周期数
+    bool idr_pending;                   // 有丢帧但还在 idr_hold 内，尚未请求 IDR
+};
+
+#endif // ABR_CONTROLLER_H
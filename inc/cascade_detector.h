@@ -0,0 +1,62 @@
+#ifndef CASCADE_DETECTOR_H
+#define CASCADE_DETECTOR_H
+
+#include <vector>
+#include <string>
+#include "yolo_detector.h"
+
+/*
+    两级级联检测：
+    - 轻量模型 (如 yolov5n-320) 每帧都跑，输出阈值放低，用来发现可疑候选
+    - 轻量模型出现置信度介于 light_conf 与 accept_conf 之间的候选，或距上次重模型已满 heavy_interval 帧时，
+      才运行重模型 (如 yolov5s-640)
+    - 合并：重模型的结果全部保留，轻量模型的高置信度结果只补充重模型没有覆盖到的目标
+    两个模型的检测框都换算到重模型输入图像的坐标系下，输出为一路结果。
+*/
+
+struct CascadeConfig {
+    float light_conf = 0.25f;       // 轻量模型的输出阈值，低于最终阈值以便发现可疑候选
+    float accept_conf = 0.5f;       // 轻量模型结果达到该置信度直接采信，不需要重模型确认
+    int heavy_interval = 15;        // 最多隔多少帧强制运行一次重模型，0 表示只按需运行
+    float merge_iou = 0.5f;         // 合并两路结果时的同类框 IoU 阈值
+};
+
+class CascadeDetector {
+public:
+    explicit CascadeDetector(const CascadeConfig& cfg = CascadeConfig());
+
+    /**
+     * 初始化两个模型，label_path 两个模型共用
+     * 轻量模型的检测框换算到重模型输入尺寸下
+     */
+    int init(const std::string& light_model, const std::string& heavy_model,
+             const std::string& label_path = LABEL_NALE_TXT_PATH);
+
+    /**
+     * 执行一帧级联推理
+     * light_img / heavy_img 分别为缩放到两个模型输入尺寸的 RGB888 图像，两个模型尺寸相同时可传同一块内存
+     */
+    int inference(unsigned char* light_img, unsigned char* heavy_img, std::vector<DetectResult>& results);
+
+    RKNNDetector& light_detector() { return light; }
+    RKNNDetector& heavy_detector() { return heavy; }
+
+    bool last_ran_heavy() const { return ran_heavy; }
+    float heavy_rate() const { return frames ? (float)heavy_frames / frames : 0.0f; }  // 运行重模型的帧占比
+    void reset_stats() { frames = 0; heavy_frames = 0; }
+
+private:
+    CascadeConfig cfg;
+    RKNNDetector light;
+    RKNNDetector heavy;
+    std::vector<DetectResult> light_results;
+    std::vector<DetectResult> heavy_results;
+    int since_heavy;        // 距上次运行重模型的帧数
+    bool ran_heavy;
+    int frames;
+    int heavy_frames;
+
+    void merge(std::vector<DetectResult>& results) const;
+};
+
+#endif // CASCADE_DETECTOR_H
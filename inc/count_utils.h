@@ -1,3 +1,12 @@
+#pragma once
+#include <chrono>
+#include <algorithm>
+#include <stdint.h>
+#include <stdio.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
 static inline int64_t now_us() {
     using namespace std::chrono;
     return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
@@ -18,4 +27,46 @@ struct StageStat {
         cnt++;
     }
     void reset() { sum_us = 0; max_us = 0; cnt = 0; }
-};
\ No newline at end of file
+};
+
+// 启动时间线：记录各子系统初始化的起止时间 (相对 origin)，并行初始化时用来查看哪一项在关键路径上
+class StartupTimeline {
+public:
+    StartupTimeline() : origin(now_us()) {}
+
+    // 记录一项从 start_us 开始、到现在结束的初始化，可在任意线程调用
+    void add(const std::string& name, int64_t start_us) {
+        int64_t end_us = now_us();
+        std::lock_guard<std::mutex> lk(mtx);
+        entries.push_back({name, start_us - origin, end_us - origin});
+    }
+
+    void report() {
+        std::lock_guard<std::mutex> lk(mtx);
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b){ return a.start < b.start; });
+        int64_t total = 0;
+        for (const auto& e : entries) total = std::max(total, e.end);
+        printf("------------------ startup timeline ------------------\n");
+        for (const auto& e : entries) {
+            // 40 格的甘特条，便于看出哪些初始化是重叠的
+            char bar[41];
+            int b0 = total ? (int)(e.start * 40 / total) : 0;
+            int b1 = total ? (int)(e.end * 40 / total) : 0;
+            for (int i = 0; i < 40; i++) bar[i] = (i >= b0 && i <= b1) ? '#' : '.';
+            bar[40] = '\0';
+            printf("[BOOT] %-16s %8.1f -> %8.1f ms (%7.1f ms) %s\n", e.name.c_str(), e.start / 1000.0,
+                   e.end / 1000.0, (e.end - e.start) / 1000.0, bar);
+        }
+        printf("------------------------------------------------------\n");
+    }
+
+private:
+    struct Entry {
+        std::string name;
+        int64_t start;
+        int64_t end;
+    };
+    int64_t origin;
+    std::vector<Entry> entries;
+    std::mutex mtx;
+};
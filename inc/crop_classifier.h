@@ -0,0 +1,59 @@
+#ifndef CROP_CLASSIFIER_H
+#define CROP_CLASSIFIER_H
+
+#include <vector>
+#include <string>
+#include "../3rdparty/rknpu2/include/rknn_api.h"
+#include "im2d.h"
+#include "dma_utils.h"
+#include "yolo_detector.h"
+
+/*
+    检测框二级分类 (如鱼类品种)：
+    - prepare：一次 RGA 任务 (imbeginJob/improcessTask/imendJob) 把所有检测框裁剪缩放进一块预先申请的批量输入张量，
+      批量张量 [N, H, W, 3] 在内存中等价于一张 W x (N*H) 的 RGB 图像，第 i 个裁剪写到第 i*H 行
+    - run：一次 rknn_run 完成 N 个裁剪的分类，检测框多于 N 时只分类前 N 个 (置信度高的优先)
+    prepare 与 run 分开，run 可以交给 NpuScheduler 以低优先级异步执行，批量张量在 run 完成前不能再次 prepare。
+*/
+
+typedef struct {
+    int track_id;           // 对应检测框的跟踪编号
+    int box_index;          // 对应检测框在 prepare 输入中的下标
+    int class_id;
+    std::string name;
+    float score;
+} ClassifyResult;
+
+class CropClassifier {
+public:
+    CropClassifier();
+    ~CropClassifier();
+
+    /**
+     * 加载分类模型，模型输入为 [N, H, W, 3] (N 为批大小)，输出为 [N, num_classes]
+     * label_path 为类别名文件 (每行一个)，为空时类别名为编号
+     */
+    int init(const std::string& model_path, const std::string& label_path = "");
+
+    // 按检测框裁剪到批量张量，frame 为检测框坐标所在的图像，返回裁剪数量 (<0 失败)
+    int prepare(const rga_buffer_t& frame, const std::vector<DetectResult>& boxes);
+    // 对 prepare 好的批量张量做一次推理
+    int run(std::vector<ClassifyResult>& results);
+
+    int batch_size() const { return batch; }
+
+private:
+    rknn_context ctx;
+    rknn_input_output_num io_num;
+    rknn_tensor_attr input_attr;
+    rknn_tensor_attr output_attr;
+    int batch, width, height, num_classes;
+    std::vector<std::string> labels;
+
+    DmaBuffer batch_buf;            // 批量输入张量
+    rga_buffer_t batch_img;         // 批量张量对应的 W x (N*H) 图像
+    std::vector<int> crop_boxes;    // 本批每个裁剪对应的检测框下标
+    std::vector<int> crop_tracks;   // 本批每个裁剪对应的跟踪编号
+};
+
+#endif // CROP_CLASSIFIER_H
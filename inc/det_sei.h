@@ -0,0 +1,57 @@
+#ifndef DET_SEI_H
+#define DET_SEI_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/*
+    检测结果随码流传输：每帧编码输出前插入一个 SEI (user_data_unregistered, payloadType 5) NAL，
+    内容为该帧的检测框、跟踪编号和采集时间戳，接收端解析后自行绘制，可以随时开关，且与画面帧严格对齐。
+    H.264 使用 SEI NAL (类型 6，1 字节 NAL 头)，H.265 使用前缀 SEI NAL (类型 39，2 字节 NAL 头)，负载相同。
+
+    负载格式 (大端)，紧跟 16 字节 UUID 之后:
+      u8  version (=1)
+      u8  count
+      u32 frame_id
+      u64 timestamp_us      采集时间戳 (V4L2 缓冲区时间)
+      count x {
+        u16 class_id
+        i32 track_id        -1 表示未跟踪
+        u16 confidence      置信度 * 65535
+        u16 left, top, right, bottom
+      }
+*/
+
+#define DET_SEI_VERSION     1
+#define DET_SEI_MAX_DETS    255
+
+struct SeiDetection {
+    int class_id;
+    int track_id;
+    float confidence;
+    int left, top, right, bottom;
+};
+
+struct DetectionSei {
+    uint32_t frame_id;
+    uint64_t timestamp_us;
+    std::vector<SeiDetection> dets;
+};
+
+// 生成完整的 SEI NAL (含 00 00 00 01 起始码和防竞争字节)，hevc 为 true 时生成 H.265 前缀 SEI，检测框超过 DET_SEI_MAX_DETS 个时截断
+void build_detection_sei(const DetectionSei& sei, std::vector<uint8_t>& nal, bool hevc = false);
+
+/**
+ * 解析一个 SEI NAL (不含起始码，从 NAL 头开始)，H.264 和 H.265 的 SEI NAL 都可以
+ * 返回 0 成功，-1 不是本格式的 SEI 或数据损坏
+ */
+int parse_detection_sei(const uint8_t* nal, size_t len, DetectionSei& sei);
+
+/**
+ * 在一段 Annex B 码流 (通常是一个访问单元) 中查找并解析检测结果 SEI
+ * 返回 0 找到，-1 没有找到
+ */
+int find_detection_sei(const uint8_t* data, size_t len, DetectionSei& sei);
+
+#endif // DET_SEI_H
@@ -0,0 +1,42 @@
+#ifndef ENCODED_FRAME_H
+#define ENCODED_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+#include <vector>
+
+/*
+    编码输出的零拷贝视图：编码器不再把 MppPacket 拼接到自己的缓冲区，而是直接返回指向 MPP 包内存的片段。
+    每个片段的 data 是带引用计数的别名指针，最后一个持有者 (UDP 发送、RTP 分包、RTSP 客户端发送队列) 释放后
+    才调用 mpp_packet_deinit 把包内存还给编码器，从 VPU 到 socket 之间最多只拷贝一次 (RTP over TCP 写缓冲)。
+*/
+
+struct EncodedSpan {
+    std::shared_ptr<uint8_t> data;  // 指向片段起始位置，同时持有底层内存
+    size_t len;
+};
+
+struct EncodedFrame {
+    std::vector<EncodedSpan> spans; // 按顺序拼接即为一个完整的 Annex B 访问单元 (条带输出时为其中的一个或几个条带)
+    size_t size;                    // 所有片段的总长度
+    bool is_idr;                    // 含 IDR (H.264) 或 IRAP (H.265) 图像，接收端可以从这里开始解码
+    bool last;                      // 是否为访问单元的最后一部分 (条带输出时一帧分多次交付，只有最后一次为 true)
+
+    EncodedFrame() : size(0), is_idr(false), last(true) {}
+
+    void clear(){
+        spans.clear();
+        size = 0;
+        is_idr = false;
+        last = true;
+    }
+};
+
+/**
+ * 按起始码把访问单元拆成 NAL 单元 (不含起始码)，结果仍然引用原来的内存
+ * 编码器输出的每个片段都由完整的 NAL 组成，NAL 不会跨片段
+ */
+void split_nal_units(const EncodedFrame& frame, std::vector<EncodedSpan>& nals);
+
+#endif // ENCODED_FRAME_H
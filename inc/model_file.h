@@ -0,0 +1,26 @@
+#ifndef MODEL_FILE_H
+#define MODEL_FILE_H
+
+#include <stddef.h> // for size_t
+
+// 只读映射的模型文件
+struct MappedFile {
+    void *data;     // 映射地址 (MAP_PRIVATE，写入不会改动文件)
+    size_t size;    // 文件大小
+};
+
+/**
+ * @brief 把模型文件映射到内存，代替整文件 malloc + fread 拷贝
+ * @param path 模型文件路径
+ * @param file 输出参数，成功时填充映射地址和大小
+ * @return 0 成功, -1 失败
+ */
+int map_model_file(const char *path, struct MappedFile *file);
+
+/**
+ * @brief 解除模型文件映射
+ * @param file map_model_file 填充的结构体
+ */
+void unmap_model_file(struct MappedFile *file);
+
+#endif // MODEL_FILE_H
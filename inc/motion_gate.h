@@ -0,0 +1,59 @@
+#ifndef MOTION_GATE_H
+#define MOTION_GATE_H
+
+#include <stdint.h>
+#include <vector>
+
+/*
+    运动门控：把每帧 YUYV 图像的亮度缩成一张小图 (默认 80x60)，与上一次推理时的小图比较，
+    画面基本没变化时跳过 NPU 推理、沿用上一次的检测结果。
+    参考帧只在推理成功后由 mark_inferred() 更新，判断为有变化但实际没有推理的帧 (未到推理间隔、推理失败)
+    不会成为参考帧，这期间的运动会在下一次比较时继续被检测到。
+    缩图和差分都是整数运算，ARM 上用 NEON 实现，640x480 一帧只需零点几毫秒。
+*/
+
+struct MotionGateConfig {
+    int thumb_w = 80;               // 缩略图宽度
+    int thumb_h = 60;               // 缩略图高度
+    int diff_thresh = 12;           // 单个像素亮度差超过该值才算变化 (0~255)，越小越灵敏
+    float min_changed_ratio = 0.002f;// 变化像素占比超过该值才认为画面有运动 (80x60 下约 10 个像素)
+    int max_skip = 30;              // 最多连续跳过的帧数，超过后强制推理一次
+};
+
+class MotionGate {
+public:
+    explicit MotionGate(const MotionGateConfig& cfg = MotionGateConfig());
+
+    /**
+     * 计算当前帧缩略图并判断是否需要推理
+     * yuyv 为 YUYV422 图像，stride 为每行字节数 (0 表示 width*2)
+     * 返回 true 表示需要推理；只做比较，参考帧不变
+     */
+    bool should_infer(const unsigned char* yuyv, int width, int height, int stride = 0);
+
+    // 本帧推理成功后调用：最近一次 should_infer() 的缩略图成为新的参考帧
+    void mark_inferred();
+
+    // 调整灵敏度：像素阈值与变化占比
+    void set_sensitivity(int diff_thresh, float min_changed_ratio);
+
+    float hit_rate() const { return total ? (float)skipped / total : 0.0f; }   // 跳过推理的比例
+    float last_changed_ratio() const { return changed_ratio; }                // 最近一帧的变化像素占比
+    void reset_stats() { total = 0; skipped = 0; }
+
+private:
+    MotionGateConfig cfg;
+    std::vector<uint8_t> thumb;     // 当前帧缩略图
+    std::vector<uint8_t> ref;       // 最近一次推理时的缩略图
+    std::vector<uint16_t> col_acc;  // 纵向累加的一行亮度和
+    bool has_ref;
+    int skip_run;                   // 距最近一次推理的帧数
+    float changed_ratio;
+    int total;
+    int skipped;
+
+    void downscale_luma(const unsigned char* yuyv, int width, int height, int stride);
+    int count_changed() const;
+};
+
+#endif // MOTION_GATE_H
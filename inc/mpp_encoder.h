@@ -6,20 +6,108 @@
 #include <rockchip/rk_mpi.h>
 #include <rockchip/mpp_buffer.h>
 #include <vector>
+#include <memory>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include "encoded_frame.h"
+
+// 编码参数：码率控制、GOP、QP 范围和 profile/level，init 时应用，运行中可通过 reconfigure 修改
+struct MppEncoderConfig {
+    MppCodingType coding = MPP_VIDEO_CodingAVC;     // H.264 (AVC) 或 H.265 (HEVC)，只在 init 时生效
+    MppEncRcMode rc_mode = MPP_ENC_RC_MODE_CBR;    // CBR / VBR / AVBR / FIXQP
+    int fps = 30;
+    int bps_target = 2500000;       // 目标码率 (bit/s)
+    int bps_min = 2000000;          // VBR/AVBR 的码率下限，CBR 时为允许的波动下限
+    int bps_max = 3000000;          // VBR/AVBR 的码率上限，CBR 时为允许的波动上限
+    int gop = 60;                   // I 帧间隔 (帧)
+    int qp_init = 26;               // 初始 QP，FIXQP 模式下为所有帧的固定 QP
+    int qp_min = 10;                // P 帧 QP 范围
+    int qp_max = 48;
+    int qp_min_i = 10;              // I 帧 QP 范围
+    int qp_max_i = 45;
+    int profile = 100;              // H.264 profile_idc：66 Baseline，77 Main，100 High (H.265 使用编码器默认的 Main)
+    int level = 40;                 // H.264 level_idc：40 表示 4.0
+    MppEncSplitMode split_mode = MPP_ENC_SPLIT_NONE;   // 条带划分：NONE 整帧一个条带，BY_BYTE 按字节数，BY_CTU 按宏块 (H.265 为 CTU) 数
+    int split_arg = 0;              // BY_BYTE 时为每个条带的最大字节数，BY_CTU 时为每个条带的宏块/CTU 数
+    bool slice_output = false;      // 条带输出：每编码完一个条带就输出一个包，不等整帧编码完成 (需要 split_mode 不为 NONE)
+    int roi_qp_delta = -6;          // ROI 编码：目标区域的 QP 偏移 (负值画质更高)，只对调用了 set_roi 的帧生效
+    int roi_bg_qp_delta = 3;        // ROI 编码：背景的 QP 偏移 (正值把码率让给目标)，仍在码率控制的总预算之内
+    int roi_margin = 16;            // 目标框向外扩展的像素，框边缘的细节同样保留
+};
+
+// ROI 编码的目标区域 (编码画面坐标)
+struct RoiBox {
+    int left, top, right, bottom;
+};
+
+// 每帧最多的 ROI 区域数 (包括背景)，MPP 的 ROI 区域编号为 0~7
+#define ENC_MAX_ROI_REGIONS 8
 
 class MppEncoder {
 public:
+    // 异步模式的输出回调 (在编码器输出线程中调用)，latency_us 为 submit 到取得码流的耗时
+    // 条带输出时每个条带回调一次，frame.last 标记一帧的最后一个条带
+    typedef std::function<void(EncodedFrame &frame, int64_t latency_us)> PacketCallback;
+    // 同步编码的条带回调，在 encode 内按顺序调用
+    typedef std::function<void(EncodedFrame &part)> SliceCallback;
+
     MppEncoder();
     ~MppEncoder();
 
-    // 初始化编码器 (宽, 高, fps)
+    // 初始化编码器 (宽, 高, fps)，其余参数使用 MppEncoderConfig 的默认值
     int init(int width, int height, int fps);
+    // 初始化编码器 (宽, 高, 编码参数)
+    int init(int width, int height, const MppEncoderConfig &config);
+
+    // 运行中修改码率控制、GOP、QP、profile/level，不重建编码上下文，从下一帧开始生效
+    int reconfigure(const MppEncoderConfig &config);
+    const MppEncoderConfig &config() const { return enc_cfg; }
+
+    // 运行中修改编码分辨率 (输入缓冲区仍按新的宽高紧密排列)，异步模式下先等待编码器中的帧全部输出
+    int resize(int width, int height);
+
+    // 请求下一帧编码为 IDR (丢包后让接收端尽快恢复)
+    int request_idr();
+
+    int get_width() const { return width; }
+    int get_height() const { return height; }
+    bool is_hevc() const { return coding == MPP_VIDEO_CodingHEVC; }
 
     // 编码一帧
     // 输入: dma_fd (RGA转换好的 NV12 数据的 FD)
-    // 输出: out_data (H264码流指针), out_len (码流长度)
+    // 输出: out (H.264/H.265 码流片段，直接引用 MPP 包内存，全部释放后包才归还编码器)
     // 返回: 0 成功
-    int encode(int dma_fd, void **out_data, size_t *out_len);
+    int encode(int dma_fd, EncodedFrame &out);
+
+    // 编码一帧，条带输出时每取得一个条带就调用 on_slice (可以立即发送)，否则整帧调用一次
+    int encode(int dma_fd, const SliceCallback &on_slice);
+
+    // 启动异步模式：最多 queue_depth 帧同时在编码器中，输出线程取得码流后调用 callback
+    int start_async(int queue_depth, PacketCallback callback);
+
+    // 异步提交一帧，在编码器中的帧数达到 queue_depth 时阻塞；set_sei 设置的 SEI 随这一帧提交
+    // 该帧的码流回调之前，调用者不能改写 dma_fd 对应的缓冲区 (需要 queue_depth + 1 块缓冲区轮流使用)
+    int submit(int dma_fd);
+
+    // 停止异步模式，已提交的帧全部输出后返回
+    void stop_async();
+
+    // 预先导入一块输入 DMA 缓冲区 (可选，未导入的 fd 在第一次 encode 时自动导入并缓存)
+    int import_buffer(int dma_fd, size_t size);
+
+    // 释放某个 fd 的导入缓存，调用者释放 (关闭) 该 DMA 缓冲区之前调用，避免 fd 号被复用后错用旧缓存
+    void release_buffer(int dma_fd);
+
+    // 设置下一帧要插入的 SEI NAL (含起始码，NAL 头须与编码格式一致)，encode 时插在第一个图像条带之前，编码后清空
+    void set_sei(std::vector<unsigned char>& nal) { pending_sei.swap(nal); }
+
+    // 设置下一帧的 ROI 区域 (例如当前帧的检测框或跟踪框)，encode/submit 时随帧提交，编码后清空
+    // 目标超过 ENC_MAX_ROI_REGIONS - 1 个时保留面积最大的；不调用时该帧不使用 ROI
+    void set_roi(const std::vector<RoiBox>& boxes) { pending_roi = boxes; }
 
     // 释放资源
     void deinit();
@@ -27,6 +115,7 @@ public:
 private:
     int width;
     int height;
+    MppCodingType coding;
     
     // MPP 上下文
     MppCtx ctx;
@@ -34,12 +123,56 @@ private:
 
     MppBufferGroup buf_grp;
 
-    // 拼包缓冲区临时变量
-    char *packet_buf;
-    size_t packet_buf_size;
+    // 当前生效的编码参数
+    MppEncoderConfig enc_cfg;
 
-    // 缓存编码头SPS/PPS
+    // 已导入的输入缓冲区：每个 DMA fd 只 import 一次，MppFrame 也随之复用
+    struct InputSlot {
+        int fd;
+        size_t size;
+        MppBuffer buffer;
+        MppFrame frame;
+    };
+    std::vector<InputSlot> inputs;
+
+    // 缓存编码头 (H.264 SPS/PPS，H.265 VPS/SPS/PPS)
     std::vector<unsigned char> codec_header;
+
+    // 待插入的 SEI NAL
+    std::vector<unsigned char> pending_sei;
+
+    // 待提交的 ROI 区域，同步编码时转换后的 MPP 区域在 encode 期间保存在 roi_regions / roi_cfg
+    std::vector<RoiBox> pending_roi;
+    std::vector<MppEncROIRegion> roi_regions;
+    MppEncROICfg roi_cfg;
+
+    // 异步模式：已提交、尚未取得码流的帧 (按提交顺序)
+    struct PendingFrame {
+        std::vector<unsigned char> sei;
+        int64_t submit_us;
+        // 该帧的 ROI，编码器取得码流前一直有效 (frame meta 中只保存指针)
+        std::vector<MppEncROIRegion> roi;
+        MppEncROICfg roi_cfg;
+    };
+    std::deque<PendingFrame> in_flight;
+    int queue_depth;
+    bool async_running;
+    PacketCallback callback;
+    std::thread output_thread;
+    std::mutex async_mtx;
+    std::condition_variable async_cv;
+
+    // 当前是否条带输出 (输出线程读取，reconfigure 可能在提交线程修改)
+    std::atomic<bool> slice_out;
+    bool slice_output() const { return slice_out; }
+    bool is_frame_end(MppPacket pkt) const;
+    void output_loop();
+    void append_packet(EncodedFrame &out, MppPacket pkt, std::vector<unsigned char> &sei);
+
+    int apply_config(MppEncCfg cfg, const MppEncoderConfig &config);
+    void attach_roi(MppFrame frame, std::vector<MppEncROIRegion> &regions, MppEncROICfg &cfg);
+    InputSlot* find_input(int dma_fd, size_t size);
+    static void add_span(EncodedFrame &out, std::shared_ptr<uint8_t> data, size_t len);
 };
 
 #endif // MPP_ENCODER_H
\ No newline at end of file
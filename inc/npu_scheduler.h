@@ -0,0 +1,77 @@
+#ifndef NPU_SCHEDULER_H
+#define NPU_SCHEDULER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/*
+    NPU 调度器：多个模型 (检测器、裁剪分类器等) 共用 NPU 时，由一个调度线程串行执行它们的推理任务。
+    - 每个模型注册时指定优先级和截止时间
+    - 调度线程每次从队列中取优先级最高、截止时间最早的任务执行，任务之间不抢占
+    - 开始执行时已超过截止时间的任务直接丢弃 (返回 NPU_TASK_EXPIRED)，低优先级模型积压时不会拖慢检测器
+*/
+
+#define NPU_TASK_EXPIRED  (-2)      // 任务超过截止时间被丢弃
+#define NPU_TASK_STOPPED  (-3)      // 调度器已停止
+
+class NpuScheduler {
+public:
+    NpuScheduler();
+    ~NpuScheduler();
+
+    /**
+     * 注册一个模型，priority 越大越优先，deadline_ms 为任务从提交到开始执行的最长等待时间 (0 表示不限)
+     * 返回模型编号，需在 start 之前调用
+     */
+    int register_model(const std::string& name, int priority, int deadline_ms);
+
+    void start();
+    void stop();
+
+    // 提交一个推理任务，任务返回值通过 future 取得
+    std::future<int> submit(int model, std::function<int()> job);
+
+    // 打印并清零各模型的运行统计
+    void report_stats();
+
+private:
+    struct ModelSlot {
+        std::string name;
+        int priority;
+        int64_t deadline_us;
+        int runs;
+        int expired;
+        int64_t wait_us;        // 排队等待时间累计
+        int64_t wait_max_us;
+        int64_t run_us;         // 执行时间累计
+    };
+
+    struct Task {
+        int model;
+        int64_t submit_us;
+        int64_t deadline_us;    // 绝对截止时间，0 表示不限
+        uint64_t seq;           // 同优先级同截止时间时按提交顺序
+        std::function<int()> job;
+        std::shared_ptr<std::promise<int> > result;
+    };
+
+    std::vector<ModelSlot> models;
+    std::vector<Task> queue;
+    uint64_t next_seq;
+    bool running;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::thread worker;
+
+    void loop();
+    size_t pick_next() const;
+};
+
+#endif // NPU_SCHEDULER_H
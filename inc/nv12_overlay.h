@@ -0,0 +1,57 @@
+#ifndef NV12_OVERLAY_H
+#define NV12_OVERLAY_H
+
+#include <stdint.h>
+#include <vector>
+
+/*
+    NV12 叠加层：直接在编码器的 NV12 输入缓冲区上绘制检测框和标签文字，不经过 RGB 图像和 OpenCV。
+    - 框和标签底色都拆成矩形，按行填充 Y 平面 (memset) 和 UV 平面 (NEON 16 字节一次)
+    - 文字使用初始化时预先光栅化的 5x7 点阵字形图集，每行先在 CPU 缓存里用掩码合成，再整行写入帧
+    - 只写框和标签覆盖的行，且从不读取帧内容，DMA 缓冲区只需在写完后刷一次 Cache
+    每个框的开销基本固定 (4 条边 + 1 行标签)，与画面内容无关。
+*/
+
+// NV12 颜色 (BT.601 limited range)
+struct OverlayColor {
+    uint8_t y, u, v;
+};
+
+// RGB 转 NV12 颜色
+OverlayColor overlay_color(uint8_t r, uint8_t g, uint8_t b);
+
+struct OverlayConfig {
+    int font_scale = 2;         // 字形放大倍数，字符单元为 (6 * scale) x (8 * scale)
+    int box_thickness = 2;      // 框线宽度 (像素，按偶数对齐)
+};
+
+class Nv12Overlay {
+public:
+    explicit Nv12Overlay(const OverlayConfig& cfg = OverlayConfig());
+
+    // 绑定要绘制的 NV12 帧 (UV 平面紧跟在 Y 平面之后)，stride 为每行字节数 (0 表示 width)
+    void begin(uint8_t* nv12, int width, int height, int stride = 0);
+
+    // 绘制矩形框，坐标超出画面时自动裁剪
+    void draw_box(int left, int top, int right, int bottom, OverlayColor color);
+    // 以 (x, y) 为左上角绘制带底色的一行文字，超出画面右侧的字符被截断，非 ASCII 字符显示为 '?'
+    void draw_label(int x, int y, const char* text, OverlayColor fg, OverlayColor bg);
+
+    int label_height() const { return cell_h + 2 * cfg.font_scale; }
+
+private:
+    OverlayConfig cfg;
+    int cell_w, cell_h;             // 字符单元尺寸
+    std::vector<uint8_t> atlas;     // 字形图集：每个字形 cell_h 行，每行 cell_w 个掩码字节 (0x00/0xFF)
+    std::vector<uint8_t> row_mask;  // 标签一行的字形掩码
+    std::vector<uint8_t> row_buf;   // 标签一行合成后的亮度
+
+    uint8_t* y_plane;
+    uint8_t* uv_plane;
+    int width, height, stride;
+
+    void build_atlas();
+    void fill_rect(int x0, int y0, int x1, int y1, OverlayColor color);
+};
+
+#endif // NV12_OVERLAY_H
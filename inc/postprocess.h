@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 #include <vector>
+#include <string>
+#include "../3rdparty/rknpu2/include/rknn_api.h"
 
 #define OBJ_NAME_MAX_SIZE 16
 #define OBJ_NUMB_MAX_SIZE 64
@@ -10,6 +12,13 @@
 #define NMS_THRESH 0.45
 #define BOX_THRESH 0.40
 #define PROP_BOX_SIZE (5 + OBJ_CLASS_NUM)
+#define LABEL_NALE_TXT_PATH "../model/coco_80_labels_list.txt"
+
+#define YOLO_HEAD_V5 0          // anchor-based：每个分支一个 [1, 3*(5+C), H, W] 输出
+#define YOLO_HEAD_V8 1          // anchor-free DFL：每个分支 box[1, 4*16, H, W] + score[1, C, H, W] (+ score_sum[1, 1, H, W])
+#define YOLO_HEAD_V5_SEG 2      // YOLOv5-seg：每个分支 [1, 3*(5+C), H, W] + 掩码系数 [1, 3*M, H, W]，最后一个输出为原型 [1, M, Hp, Wp]
+#define YOLO_BRANCH_NUM 3       // 检测分支数 (P3/P4/P5)
+#define YOLO_DFL_LEN 16         // YOLOv8 DFL 每条边的分布长度
 
 typedef struct _BOX_RECT
 {
@@ -34,10 +43,99 @@ typedef struct _detect_result_group_t
     detect_result_t results[OBJ_NUMB_MAX_SIZE];
 } detect_result_group_t;
 
-int post_process(int8_t *input0, int8_t *input1, int8_t *input2, int model_in_h, int model_in_w,
-                 float conf_threshold, float nms_threshold, BOX_RECT pads, float scale_w, float scale_h,
-                 std::vector<int32_t> &qnt_zps, std::vector<float> &qnt_scales,
-                 detect_result_group_t *group);
+// int8 输出只有 256 种取值：初始化时按每个输出的 zp/scale 预先算好查表，
+// 解码时用 (uint8_t)q 作为下标，避免逐候选框的反量化和浮点变换
+typedef struct _qnt_lut_t
+{
+    int32_t zp;
+    float scale;
+    float thres;          // thres_i8 对应的浮点阈值
+    int8_t thres_i8;      // 量化后的置信度阈值
+    float deqnt[256];     // 反量化值
+    float box_xy[256];    // 中心偏移 x*2-0.5
+    float box_wh[256];    // 宽高系数 (x*2)^2
+    float dfl_exp[256];   // DFL softmax 用的 exp(x)
+} qnt_lut_t;
+
+// 检测头描述：由模型输出属性推断，决定后处理选用哪个解码器
+typedef struct _yolo_head_t
+{
+    int type;                               // YOLO_HEAD_V5 / YOLO_HEAD_V8
+    int class_num;                          // 类别数
+    int output_per_branch;                  // 每个分支的输出个数 (v5: 1, v8: 2 或 3)
+    int grid_h[YOLO_BRANCH_NUM];
+    int grid_w[YOLO_BRANCH_NUM];
+    int stride[YOLO_BRANCH_NUM];
+    int anchor[YOLO_BRANCH_NUM][6];         // 仅 v5 使用
+    int mask_dim;                           // 掩码系数个数 M (仅 seg 使用，其余为 0)
+    int proto_h;                            // 原型张量高度
+    int proto_w;                            // 原型张量宽度
+} yolo_head_t;
+
+// 类别过滤：解码时只遍历关注的类别通道，低于该类别阈值的候选框在 NMS 前丢弃
+typedef struct _class_filter_t
+{
+    std::vector<int> ids;           // 关注的类别 id (为空表示全部类别)
+    std::vector<float> thres;       // 按类别 id 索引的置信度阈值，大小等于 class_num
+    std::vector<uint8_t> thres_set; // 该类别的阈值是否单独设置过 (设置过的不再跟随全局阈值)
+} class_filter_t;
+
+// 实例分割掩码：只在检测框内、以原型张量的分辨率 (模型输入的 1/4) 生成
+typedef struct _seg_mask_t
+{
+    int left;                     // 掩码 ROI 在原型网格中的位置
+    int top;
+    int width;
+    int height;
+    float stride_x;               // 一个掩码像素对应的输出图像像素数
+    float stride_y;
+    float origin_x;               // 掩码 ROI 左上角在输出图像中的坐标
+    float origin_y;
+    std::vector<uint8_t> bitmap;  // width * height，按行存储，1 表示属于目标
+} seg_mask_t;
+
+int init_yolo_head(yolo_head_t *head, const rknn_tensor_attr *output_attrs, int n_output, int model_in_h,
+                   int model_in_w);
+
+void init_qnt_lut(qnt_lut_t *lut, int32_t zp, float scale, float conf_threshold);
+
+// 后处理上下文：每个检测器实例独占一份，post_process 只读写自己的上下文，
+// 不同实例可以在不同线程上并发后处理，无需加锁
+typedef struct _post_process_ctx_t
+{
+    yolo_head_t head;                       // 检测头描述
+    std::vector<qnt_lut_t> luts;            // 每个输出的查找表
+    std::vector<std::string> labels;        // 类别名，大小等于 class_num
+    float conf_threshold;                   // 全局置信度阈值
+    float nms_threshold;                    // NMS IoU 阈值
+    class_filter_t filter;                  // 类别过滤与类别阈值
+    bool use_filter;                        // filter 是否生效
+    float gate_threshold;                   // 解码时的量化阈值 (全局阈值与关注类别阈值中的最小值)
+
+    // 逐帧复用的临时缓冲区，clear() 后保留容量，稳态下不再分配内存
+    std::vector<float> filterBoxes;
+    std::vector<float> objProbs;
+    std::vector<int> classId;
+    std::vector<int> indexArray;
+    std::vector<int> classList;
+    std::vector<float> maskCoefs;           // seg：每个候选框的掩码系数 (mask_dim 个)
+} post_process_ctx_t;
+
+int init_post_process(post_process_ctx_t *ctx, const rknn_tensor_attr *output_attrs, int n_output, int model_in_h,
+                      int model_in_w, const char *label_path);
+
+int post_process_set_input_size(post_process_ctx_t *ctx, const rknn_tensor_attr *output_attrs, int n_output,
+                                int model_in_h, int model_in_w);
+
+int post_process_set_class_filter(post_process_ctx_t *ctx, const std::vector<int> &class_ids);
+
+int post_process_set_conf_threshold(post_process_ctx_t *ctx, float threshold);
+
+int post_process_set_class_threshold(post_process_ctx_t *ctx, int class_id, float threshold);
+
+// masks 不为空且模型为 seg 时，按 group->results 的顺序输出每个检测框的掩码
+int post_process(post_process_ctx_t *ctx, int8_t **inputs, int model_in_h, int model_in_w, BOX_RECT pads,
+                 float scale_w, float scale_h, detect_result_group_t *group, std::vector<seg_mask_t> *masks = nullptr);
 
-void deinitPostProcess();
+void deinit_post_process(post_process_ctx_t *ctx);
 #endif //_RKNN_YOLOV5_DEMO_POSTPROCESS_H_
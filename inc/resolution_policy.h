@@ -0,0 +1,56 @@
+#ifndef RESOLUTION_POLICY_H
+#define RESOLUTION_POLICY_H
+
+#include <stdint.h>
+#include <vector>
+#include "yolo_detector.h"
+
+/*
+    动态输入尺寸策略：根据推理耗时和画面复杂度在模型支持的几档输入尺寸 (如 320/480/640) 之间切换。
+    - 推理耗时 (指数平均) 超出预算：降一档
+    - 画面复杂 (小目标或目标很多) 且升档后的预估耗时仍在预算内：升一档
+    - 画面简单 (只有大目标)：降一档，节省 NPU 时间
+    每次切换后至少保持 hold_frames 帧，避免来回抖动。
+    update 只给出建议的尺寸，调用方切换成功后调用 commit，失败时调用 reject，策略的当前档位始终与检测器一致。
+*/
+
+struct ResolutionPolicyConfig {
+    float latency_budget_ms = 25.0f;    // 单帧推理 (含后处理) 耗时预算
+    int small_box = 24;                 // 检测框短边小于该值 (输出坐标系像素) 视为小目标
+    int crowded_count = 10;             // 检测数达到该值视为画面复杂
+    int hold_frames = 30;               // 两次切换之间至少间隔的推理帧数
+    float ema_alpha = 0.1f;             // 耗时指数平均系数
+};
+
+class ResolutionPolicy {
+public:
+    explicit ResolutionPolicy(const ResolutionPolicyConfig& cfg = ResolutionPolicyConfig());
+
+    // 设置可选尺寸 (按面积从小到大) 和当前尺寸
+    void set_sizes(const std::vector<InputSize>& sizes, int current_width, int current_height);
+
+    /**
+     * 每次推理后调用，infer_us 为本次推理耗时，results 为本次检测结果
+     * 返回 true 表示建议切换尺寸，next 为新的输入尺寸，调用方切换后必须调用 commit 或 reject
+     */
+    bool update(int64_t infer_us, const std::vector<DetectResult>& results, InputSize& next);
+    // 检测器已切换到 update 建议的尺寸
+    void commit();
+    // 检测器切换失败，保持当前档位，hold_frames 帧后才会再次建议
+    void reject();
+
+    float avg_latency_ms() const { return ema_us / 1000.0f; }
+    int switch_count() const { return switches; }
+
+private:
+    ResolutionPolicyConfig cfg;
+    std::vector<InputSize> sizes;
+    int current;
+    int proposed;       // update 建议、尚未确认的档位，-1 表示没有
+    float ema_us;
+    bool has_ema;
+    int since_switch;
+    int switches;
+};
+
+#endif // RESOLUTION_POLICY_H
@@ -0,0 +1,30 @@
+#ifndef _RKNN_SEG_MASK_H_
+#define _RKNN_SEG_MASK_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "postprocess.h"
+
+// 实例分割掩码生成：只在检测框 ROI 内、以原型分辨率计算
+// 掩码 logit = sum_k c_k * P_k(x, y)，sigmoid(logit) > 0.5 等价于 logit > 0，不需要算 sigmoid。
+// 系数 c 按框对称量化为 int8，原型 P 直接使用 int8 输出：
+//   sum_k c_k * (p_k - zp) = sum_k c_k * p_k - zp * sum_k c_k
+// 逐像素只剩 int8 乘加，zp 项每个框只算一次。
+
+/**
+ * 生成一个检测框的掩码
+ * proto     原型张量 (NCHW int8，[mask_dim, proto_h, proto_w])
+ * proto_zp  原型张量的量化零点
+ * coefs     该框反量化后的 mask_dim 个系数
+ * x1..y2    检测框在模型输入坐标下的位置
+ * 输出的 stride/origin 为模型输入坐标，调用方再按 pads/scale 换算到图像坐标
+ */
+void build_roi_mask(const int8_t *proto, int mask_dim, int proto_h, int proto_w, int32_t proto_zp,
+                    const float *coefs, float x1, float y1, float x2, float y2, int model_in_h, int model_in_w,
+                    seg_mask_t *mask);
+
+// 把掩码位图按行编码为 RLE：交替记录 0 和 1 的游程长度，第一个游程为 0 (可以为 0 长度)
+void seg_mask_to_rle(const seg_mask_t *mask, std::vector<uint32_t> &rle);
+
+#endif //_RKNN_SEG_MASK_H_
@@ -0,0 +1,60 @@
+#ifndef TENSOR_REPLAY_H
+#define TENSOR_REPLAY_H
+
+#include "../3rdparty/rknpu2/include/rknn_api.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+    原始输出张量的录制与回放，用于脱离 NPU 调试/评测后处理。
+    目录格式：
+    - attrs.txt          模型输入尺寸与每个输出的属性 (fmt、dims、zp、scale、字节数)
+    - frame_000000.bin   一帧的全部 int8 输出按输出顺序直接拼接
+*/
+
+class TensorRecorder {
+public:
+    TensorRecorder();
+
+    // 打开录制目录并写入 attrs.txt，max_frames 为 0 表示不限帧数
+    int open(const std::string& dir, const rknn_tensor_attr* attrs, int n_output,
+             int model_w, int model_h, int max_frames = 0);
+    // 录制一帧输出，达到 max_frames 后不再写入
+    int write(int8_t** outputs);
+    bool is_open() const { return !dir.empty(); }
+    int frame_count() const { return frames; }
+
+private:
+    std::string dir;
+    std::vector<uint32_t> sizes;
+    int frames;
+    int max_frames;
+};
+
+class TensorReplayer {
+public:
+    TensorReplayer();
+
+    // 读取目录下的 attrs.txt 和全部帧到内存
+    int open(const std::string& dir);
+
+    int frame_count() const { return (int)frames.size(); }
+    int output_count() const { return (int)attrs.size(); }
+    const rknn_tensor_attr* output_attrs() const { return attrs.data(); }
+    int model_width() const { return model_w; }
+    int model_height() const { return model_h; }
+
+    // 取第 idx 帧的输出指针，outputs 至少要有 output_count() 个元素
+    int frame(int idx, int8_t** outputs);
+    // 依次循环取帧
+    int next(int8_t** outputs);
+
+private:
+    std::vector<rknn_tensor_attr> attrs;
+    std::vector<std::vector<int8_t> > frames;
+    int model_w, model_h;
+    int cursor;
+};
+
+#endif // TENSOR_REPLAY_H
@@ -0,0 +1,76 @@
+#ifndef TILED_DETECTOR_H
+#define TILED_DETECTOR_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include "im2d.h"
+#include "dma_utils.h"
+#include "yolo_detector.h"
+
+/*
+    分块推理：把高分辨率帧切成若干相互重叠、与模型输入等大的分块，逐块检测后在整帧坐标下做一次全局 NMS。
+    远处的小目标不会因为整帧压缩到 640x640 而消失。
+    - 每个分块一块预先申请的 DMA 内存，RGA 直接从原始帧裁剪 (并做格式转换) 到分块内存，CPU 不搬运像素
+    - 每个 NPU 核心一个 RKNNDetector 实例 (独立的 rknn 上下文)，分块按轮询分给各核心并行推理
+    - 每帧记录裁剪、推理、NMS 的耗时，便于在召回率和延迟之间取舍
+*/
+
+struct TiledConfig {
+    int overlap = 64;           // 相邻分块的最小重叠像素，应不小于待检测小目标的尺寸
+    int workers = 3;            // 并行推理的 NPU 核心数 (1~3)
+    float nms_iou = 0.45f;      // 全局 NMS 的 IoU 阈值
+};
+
+// 最近一帧的开销统计 (微秒)
+struct TiledStats {
+    int tiles;
+    int64_t crop_us;            // 各分块 RGA 裁剪耗时之和
+    int64_t infer_us;           // 各分块 NPU 推理 (含后处理) 耗时之和
+    int64_t wall_us;            // 裁剪+推理的实际墙钟时间 (多核并行后)
+    int64_t nms_us;             // 全局 NMS 耗时
+};
+
+class TiledDetector {
+public:
+    explicit TiledDetector(const TiledConfig& cfg = TiledConfig());
+    ~TiledDetector();
+
+    /**
+     * 加载模型并按帧尺寸规划分块，每个分块与模型输入等大 (帧比模型小时整帧作为一个分块)
+     * 返回 0 成功，-1 失败
+     */
+    int init(const std::string& model_path, int frame_width, int frame_height,
+             const std::string& label_path = LABEL_NALE_TXT_PATH);
+
+    /**
+     * 对一帧做分块推理，frame 为 RGA 可访问的整帧图像 (任意 RGA 支持的格式)
+     * results 为整帧坐标下的检测框
+     */
+    int inference(const rga_buffer_t& frame, std::vector<DetectResult>& results);
+
+    int tile_count() const { return (int)tiles.size(); }
+    const TiledStats& last_stats() const { return stats; }
+
+private:
+    struct Tile {
+        im_rect rect;           // 在整帧中的位置
+        DmaBuffer buf;          // 模型输入 (RGB888)
+        rga_buffer_t img;
+    };
+
+    TiledConfig cfg;
+    std::vector<std::unique_ptr<RKNNDetector> > detectors;   // 每个 NPU 核心一个
+    std::vector<Tile> tiles;
+    std::vector<std::vector<DetectResult> > tile_results;
+    std::vector<int64_t> worker_crop_us;
+    std::vector<int64_t> worker_infer_us;
+    std::vector<int> worker_ret;
+    TiledStats stats;
+
+    void plan_tiles(int frame_width, int frame_height, int tile_w, int tile_h);
+    void run_worker(int worker, const rga_buffer_t& frame);
+    void release();
+};
+
+#endif // TILED_DETECTOR_H
@@ -0,0 +1,75 @@
+#ifndef OBJECT_TRACKER_H
+#define OBJECT_TRACKER_H
+
+#include <vector>
+#include "yolo_detector.h"
+
+/*
+    多目标跟踪 (SORT/ByteTrack 风格)：
+    - 每条轨迹用匀速模型的卡尔曼滤波预测框的中心和宽高，4 个坐标各自独立成 2 维滤波器
+    - 有检测的帧：先用高分检测框按 IoU 关联，再用低分检测框关联剩余轨迹，未匹配的高分框新建轨迹；
+      输出仍是检测器的原始框，只填上 track_id，不会滞后或丢弃任何检测
+    - 没有检测的帧：只做预测，输出最近一次有检测的帧上关联到检测框的轨迹 (含未确认的) 的预测框，
+      跳帧期间显示的目标集合与上一次推理一致，刚消失的目标不会在跳帧时重新出现
+    所有计算都在 CPU 上完成，几十个目标的一次更新耗时在微秒级。
+*/
+
+struct TrackerConfig {
+    float high_thresh = BOX_THRESH; // 高分检测框阈值，只有高分框可以新建轨迹 (默认与检测器的置信度阈值一致)
+    float low_thresh = 0.1f;    // 低于该分数的检测框直接丢弃
+    float match_iou = 0.3f;     // 关联时的最小 IoU
+    int min_hits = 2;           // 连续命中多少次后轨迹才确认 (才输出 track_id 和预测框)
+    int max_lost = 30;          // 连续多少帧未关联后删除轨迹 (按帧计，包括跳过推理的帧)
+};
+
+class ObjectTracker {
+public:
+    explicit ObjectTracker(const TrackerConfig& cfg = TrackerConfig());
+
+    // 有检测结果的帧：关联检测框并更新轨迹，dets 保持原样，只填上 track_id (未关联或轨迹未确认时为 -1)
+    void update(std::vector<DetectResult>& dets);
+    // 没有检测结果的帧：轨迹向前预测一帧，out 为最近一次 update() 中关联到检测框的轨迹的预测框
+    void predict(std::vector<DetectResult>& out);
+    // 清空全部轨迹
+    void reset();
+
+    int track_count() const { return (int)tracks.size(); }
+
+private:
+    // 单个坐标的匀速卡尔曼滤波器，状态为 (位置, 速度)
+    struct Kalman1D {
+        float x, v;             // 状态
+        float p00, p01, p11;    // 协方差 (对称)
+        void init(float z, float std_pos, float std_vel);
+        void predict(float q_pos, float q_vel);
+        void update(float z, float r);
+    };
+
+    enum TrackState { TRACK_TENTATIVE = 0, TRACK_CONFIRMED };
+
+    struct Track {
+        int id;
+        int class_id;
+        std::string name;
+        float confidence;
+        Kalman1D kf[4];         // cx, cy, w, h
+        int hits;
+        int lost;
+        TrackState state;
+        bool shown;             // 最近一次 update() 中关联到了检测框，跳帧时输出其预测框
+    };
+
+    TrackerConfig cfg;
+    std::vector<Track> tracks;
+    int next_id;
+
+    void predict_tracks();
+    void match(const std::vector<DetectResult>& dets, const std::vector<int>& det_idx,
+               std::vector<int>& track_pool, std::vector<int>& unmatched_dets, std::vector<int>& det_track);
+    void init_track(Track& t, const DetectResult& det);
+    void update_track(Track& t, const DetectResult& det);
+    void emit(std::vector<DetectResult>& out) const;
+    static DetectResult to_result(const Track& t);
+};
+
+#endif // OBJECT_TRACKER_H
@@ -1,5 +1,6 @@
 // socket相关
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <string.h>
@@ -9,14 +10,20 @@ extern "C"{
 #endif
 
 #define UDP_MTU  1024  // UDP分片大小，通常小于1500字节以避免IP层分片
+#define UDP_SEND_TIMEOUT_MS  20 // 发送缓冲区满时最多阻塞的时间，超时即视为拥塞并放弃这一帧剩余的数据
 
 typedef struct UdpContext{
     int socket_fd;
     struct sockaddr_in dest_addr;
+    int sndbuf;                     // 内核实际的发送缓冲区大小 (字节)
+    unsigned int send_failures;     // 累计发送失败 (超时或错误) 次数
 } UdpContext;
 
 int udp_init(UdpContext *ctx, const char *dest_ip, int port);
-void udp_send(UdpContext *ctx, void *data, size_t len);
+int udp_send(UdpContext *ctx, void *data, size_t len);
+int udp_sendv(UdpContext *ctx, const struct iovec *iov, int iovcnt);
+// 发送缓冲区中尚未发出的字节数 (SIOCOUTQ)，失败返回 -1
+int udp_queued_bytes(UdpContext *ctx);
 
 #ifdef __cplusplus
 }
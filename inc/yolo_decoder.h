@@ -0,0 +1,232 @@
+#ifndef _RKNN_YOLO_DECODER_H_
+#define _RKNN_YOLO_DECODER_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "postprocess.h"
+
+// YOLO 检测头解码器模板族
+// NC 为编译期类别数 (0 表示运行时由 class_num 决定)，常见配置在 postprocess.cc 中显式实例化，
+// 类别循环次数成为常量后编译器可以完全展开 argmax，小类别模型的解码开销随类别数等比例下降。
+// 所有解码器只做查表 (qnt_lut_t)，输出格式与 post_process 的 NMS 输入一致：
+// boxes 按 (x, y, w, h) 追加，objProbs/classId 一一对应。
+// filter 不为空时只遍历 filter->ids 中的类别通道，并按类别阈值在 NMS 前丢弃候选框。
+// seg 模型额外把每个候选框的 mask_dim 个掩码系数 (反量化后) 追加到 coefs，与 objProbs 一一对应。
+
+// 在类别通道上求 argmax，cls_ptr 指向第 0 个类别，通道间隔 grid_len
+template <int NC>
+static inline int argmax_class(const int8_t *cls_ptr, int grid_len, int class_num, const class_filter_t *filter,
+                               int8_t *max_prob)
+{
+  int maxClassId;
+  int8_t maxClassProbs;
+  if (filter != nullptr && !filter->ids.empty())
+  {
+    const int *ids = filter->ids.data();
+    const int n = (int)filter->ids.size();
+    maxClassId = ids[0];
+    maxClassProbs = cls_ptr[ids[0] * grid_len];
+    for (int k = 1; k < n; ++k)
+    {
+      int8_t prob = cls_ptr[ids[k] * grid_len];
+      if (prob > maxClassProbs)
+      {
+        maxClassId = ids[k];
+        maxClassProbs = prob;
+      }
+    }
+  }
+  else
+  {
+    const int nc = NC > 0 ? NC : class_num;
+    maxClassId = 0;
+    maxClassProbs = cls_ptr[0];
+    for (int k = 1; k < nc; ++k)
+    {
+      int8_t prob = cls_ptr[k * grid_len];
+      if (prob > maxClassProbs)
+      {
+        maxClassId = k;
+        maxClassProbs = prob;
+      }
+    }
+  }
+  *max_prob = maxClassProbs;
+  return maxClassId;
+}
+
+template <int NC>
+static inline int decode_yolov5_branch(const int8_t *input, const int *anchor, int grid_h, int grid_w, int stride,
+                                       int class_num, const qnt_lut_t *lut, const class_filter_t *filter,
+                                       std::vector<float> &boxes, std::vector<float> &objProbs,
+                                       std::vector<int> &classId, const int8_t *mask_in = nullptr,
+                                       const qnt_lut_t *mask_lut = nullptr, int mask_dim = 0,
+                                       std::vector<float> *coefs = nullptr)
+{
+  const int nc = NC > 0 ? NC : class_num;
+  const int prop_box_size = 5 + nc;
+  int validCount = 0;
+  int grid_len = grid_h * grid_w;
+  int8_t thres_i8 = lut->thres_i8;
+  for (int a = 0; a < 3; a++)
+  {
+    for (int i = 0; i < grid_h; i++)
+    {
+      for (int j = 0; j < grid_w; j++)
+      {
+        int8_t box_confidence = input[(prop_box_size * a + 4) * grid_len + i * grid_w + j];
+        if (box_confidence >= thres_i8)
+        {
+          int offset = (prop_box_size * a) * grid_len + i * grid_w + j;
+          const int8_t *in_ptr = input + offset;
+
+          int8_t maxClassProbs;
+          int maxClassId = argmax_class<NC>(in_ptr + 5 * grid_len, grid_len, class_num, filter, &maxClassProbs);
+          if (maxClassProbs > thres_i8)
+          {
+            float score = lut->deqnt[(uint8_t)maxClassProbs] * lut->deqnt[(uint8_t)box_confidence];
+            if (filter != nullptr && score < filter->thres[maxClassId])
+            {
+              continue;
+            }
+
+            float box_x = (lut->box_xy[(uint8_t)in_ptr[0]] + j) * (float)stride;
+            float box_y = (lut->box_xy[(uint8_t)in_ptr[grid_len]] + i) * (float)stride;
+            float box_w = lut->box_wh[(uint8_t)in_ptr[2 * grid_len]] * (float)anchor[a * 2];
+            float box_h = lut->box_wh[(uint8_t)in_ptr[3 * grid_len]] * (float)anchor[a * 2 + 1];
+            box_x -= (box_w / 2.0);
+            box_y -= (box_h / 2.0);
+
+            objProbs.push_back(score);
+            classId.push_back(maxClassId);
+            validCount++;
+            boxes.push_back(box_x);
+            boxes.push_back(box_y);
+            boxes.push_back(box_w);
+            boxes.push_back(box_h);
+
+            if (mask_in != nullptr)
+            {
+              const int8_t *coef_ptr = mask_in + (mask_dim * a) * grid_len + i * grid_w + j;
+              for (int k = 0; k < mask_dim; k++)
+              {
+                coefs->push_back(mask_lut->deqnt[(uint8_t)coef_ptr[k * grid_len]]);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  return validCount;
+}
+
+// DFL：对每条边的 REG_MAX 个 bin 做 softmax 后求期望，exp 由 LUT 提供
+template <int REG_MAX>
+static inline void decode_dfl(const int8_t *box_in, int grid_len, const qnt_lut_t *lut, float *box)
+{
+  for (int b = 0; b < 4; b++)
+  {
+    float exp_sum = 0;
+    float acc_sum = 0;
+    for (int k = 0; k < REG_MAX; k++)
+    {
+      float e = lut->dfl_exp[(uint8_t)box_in[(b * REG_MAX + k) * grid_len]];
+      exp_sum += e;
+      acc_sum += e * k;
+    }
+    box[b] = acc_sum / exp_sum;
+  }
+}
+
+template <int NC, int REG_MAX>
+static inline int decode_yolov8_branch(const int8_t *box_in, const int8_t *score_in, const int8_t *score_sum_in,
+                                       int grid_h, int grid_w, int stride, int class_num, const qnt_lut_t *box_lut,
+                                       const qnt_lut_t *score_lut, const qnt_lut_t *score_sum_lut,
+                                       const class_filter_t *filter, std::vector<float> &boxes,
+                                       std::vector<float> &objProbs, std::vector<int> &classId)
+{
+  int validCount = 0;
+  int grid_len = grid_h * grid_w;
+  int8_t score_thres_i8 = score_lut->thres_i8;
+  int8_t score_sum_thres_i8 = score_sum_lut ? score_sum_lut->thres_i8 : 0;
+  for (int i = 0; i < grid_h; i++)
+  {
+    for (int j = 0; j < grid_w; j++)
+    {
+      int offset = i * grid_w + j;
+      // score_sum 是所有类别分数之和 (截断到 1)，低于阈值时整格不可能有目标
+      if (score_sum_in != nullptr && score_sum_in[offset] < score_sum_thres_i8)
+      {
+        continue;
+      }
+
+      int8_t max_score;
+      int max_class_id = argmax_class<NC>(score_in + offset, grid_len, class_num, filter, &max_score);
+      if (max_score > score_thres_i8)
+      {
+        float score = score_lut->deqnt[(uint8_t)max_score];
+        if (filter != nullptr && score < filter->thres[max_class_id])
+        {
+          continue;
+        }
+
+        float box[4];
+        decode_dfl<REG_MAX>(box_in + offset, grid_len, box_lut, box);
+        float x1 = (-box[0] + j + 0.5f) * stride;
+        float y1 = (-box[1] + i + 0.5f) * stride;
+        float x2 = (box[2] + j + 0.5f) * stride;
+        float y2 = (box[3] + i + 0.5f) * stride;
+
+        objProbs.push_back(score);
+        classId.push_back(max_class_id);
+        validCount++;
+        boxes.push_back(x1);
+        boxes.push_back(y1);
+        boxes.push_back(x2 - x1);
+        boxes.push_back(y2 - y1);
+      }
+    }
+  }
+  return validCount;
+}
+
+// 依次解码三个分支，inputs/luts 按模型输出顺序排列
+template <int NC>
+static inline int decode_yolo_head(int8_t **inputs, const yolo_head_t *head, const qnt_lut_t *luts,
+                                   const class_filter_t *filter, std::vector<float> &boxes,
+                                   std::vector<float> &objProbs, std::vector<int> &classId,
+                                   std::vector<float> *coefs = nullptr)
+{
+  int validCount = 0;
+  for (int b = 0; b < YOLO_BRANCH_NUM; b++)
+  {
+    if (head->type == YOLO_HEAD_V5)
+    {
+      validCount += decode_yolov5_branch<NC>(inputs[b], head->anchor[b], head->grid_h[b], head->grid_w[b],
+                                             head->stride[b], head->class_num, &luts[b], filter, boxes, objProbs,
+                                             classId);
+    }
+    else if (head->type == YOLO_HEAD_V5_SEG)
+    {
+      // 输出顺序为 box0, mask0, box1, mask1, box2, mask2, proto
+      int idx = b * 2;
+      validCount += decode_yolov5_branch<NC>(inputs[idx], head->anchor[b], head->grid_h[b], head->grid_w[b],
+                                             head->stride[b], head->class_num, &luts[idx], filter, boxes, objProbs,
+                                             classId, inputs[idx + 1], &luts[idx + 1], head->mask_dim, coefs);
+    }
+    else
+    {
+      int idx = b * head->output_per_branch;
+      bool has_sum = head->output_per_branch > 2;
+      validCount += decode_yolov8_branch<NC, YOLO_DFL_LEN>(
+          inputs[idx], inputs[idx + 1], has_sum ? inputs[idx + 2] : nullptr, head->grid_h[b], head->grid_w[b],
+          head->stride[b], head->class_num, &luts[idx], &luts[idx + 1], has_sum ? &luts[idx + 2] : nullptr, filter,
+          boxes, objProbs, classId);
+    }
+  }
+  return validCount;
+}
+
+#endif //_RKNN_YOLO_DECODER_H_
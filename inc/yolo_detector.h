@@ -2,45 +2,119 @@
 #define RKNN_DETECTOR_H
 
 #include "../3rdparty/rknpu2/include/rknn_api.h"
+#include "postprocess.h"
+#include "tensor_replay.h"
+#include "model_file.h"
 #include <vector>
 #include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
 
 // 定义检测结果结构体 (和 postprocess.h 里保持一致最好)
 typedef struct {
     int id;
     std::string name;   
     float confidence;
+    int track_id;       // 跟踪编号，未经过跟踪器时为 -1
     struct {
         int left, top, right, bottom;
     } box;
 } DetectResult;
 
+// 模型输入尺寸
+typedef struct {
+    int width;
+    int height;
+} InputSize;
+
+// 两个检测框的 IoU
+float detect_result_iou(const DetectResult& a, const DetectResult& b);
+// 按类别做 NMS：置信度高的框优先保留，与其 IoU 超过 iou_thresh 的同类框被删除
+void nms_detect_results(std::vector<DetectResult>& dets, float iou_thresh);
+
 class RKNNDetector{
 public:
     RKNNDetector();
     ~RKNNDetector();
 
-    int init(const std::string& model_path);
+    int init(const std::string& model_path, const std::string& label_path = LABEL_NALE_TXT_PATH);
     int inference(unsigned char* img_data, std::vector<DetectResult>& results);
     rknn_context *get_ctx();
 
+    // 录制原始输出张量，用于离线回放和后处理评测
+    int set_capture(const std::string& dir, int max_frames = 0);
+    // 回放模式初始化：用录制的输出张量代替 NPU 推理
+    int init_replay(const std::string& capture_dir, const std::string& label_path = LABEL_NALE_TXT_PATH);
+
+    // 类别过滤：只解码关注的类别 (class_ids 为空表示恢复全部类别)，需在 init 之后调用
+    int set_class_filter(const std::vector<int>& class_ids);
+    // 单独设置某个类别的置信度阈值，需在 init 之后调用
+    int set_class_threshold(int class_id, float threshold);
+    // 绑定 NPU 核心，需在 init 之后调用
+    int set_core_mask(rknn_core_mask core_mask);
+    // 设置全局置信度阈值，需在 init 之后调用
+    int set_conf_threshold(float threshold);
+
+    // 设置检测框输出坐标系的尺寸，默认与模型输入尺寸相同 (0 表示不缩放)
+    void set_output_size(int out_width, int out_height);
+    int model_width() const { return width; }
+    int model_height() const { return height; }
+
+    /**
+     * 热切换模型：后台线程加载新模型 (rknn_init、属性查询、预热推理)，加载完成后在下一次 inference 开始时切换，
+     * 旧模型在后台线程释放。视频流不中断，切换那一帧只多一次指针交换的开销
+     * 返回 0 表示已开始加载，-1 表示已有模型在加载中或处于回放模式
+     */
+    int load_model_async(const std::string& model_path, const std::string& label_path = LABEL_NALE_TXT_PATH);
+    bool swap_pending() const { return loading; }
+    const std::string& current_model() const { return model_path; }
+
+    // 动态输入模型：可选的输入尺寸 (按面积从小到大)，非动态模型为空
+    bool is_dynamic() const { return !input_sizes.empty(); }
+    const std::vector<InputSize>& supported_input_sizes() const { return input_sizes; }
+    // 切换动态输入模型的输入尺寸，后处理的网格和步长随之更新，需在 init 之后、与 inference 同一线程调用
+    int set_input_size(int input_width, int input_height);
+
+    // 实例分割模型 (YOLOv5-seg)：inference 后 last_masks() 与 results 按下标一一对应
+    bool is_segmentation() const { return pp_ctx.head.type == YOLO_HEAD_V5_SEG; }
+    const std::vector<seg_mask_t>& last_masks() const { return masks; }
+
 private:
     rknn_context ctx;   // RKNN上下文句柄
-    unsigned char* model_data;
-    int model_data_size;
+    MappedFile model_file;  // 映射的模型文件
     
     std::string model_path;
 
     rknn_input_output_num io_num;   // 输入输出数量
     rknn_tensor_attr* input_attrs;  // 输入属性
     rknn_tensor_attr* output_attrs; // 输出属性
-
-    float nms_threshold, box_conf_threshold;
+    post_process_ctx_t pp_ctx;      // 本实例独占的后处理上下文 (检测头、查找表、标签、阈值、临时缓冲)
+    std::vector<seg_mask_t> masks;  // 最近一帧的实例掩码 (仅分割模型)
 
     int channel, width, height; // 模型输入尺寸
-    int img_width, img_height; // 原始图像尺寸
+    int img_width, img_height; // 原始图像尺寸 (检测框输出坐标系)
+    std::vector<InputSize> input_sizes; // 动态输入模型支持的输入尺寸
+    rknn_core_mask core_mask;   // set_core_mask 设置的核心，热切换时沿用
+
+    std::thread loader;                     // 热切换的后台加载线程
+    std::mutex swap_mtx;
+    std::unique_ptr<RKNNDetector> staged;   // 加载完成、等待切换的模型
+    std::atomic<bool> loading;              // 后台加载或等待切换中
+
+    TensorRecorder recorder;    // 输出张量录制
+    TensorReplayer replayer;    // 输出张量回放
+    bool replay;                // 是否处于回放模式
 
-    unsigned char* load_model_from_file(const char* filename, int* model_size);
+    void update_input_dims();
+    void query_input_sizes();
+    int apply_input_shape(int input_width, int input_height);
+    void load_worker(std::string model_path, std::string label_path, int want_width, int want_height, int want_channel);
+    static int match_input(RKNNDetector& next, int want_width, int want_height, int want_channel);
+    void apply_staged_model();
+    void swap_model(RKNNDetector& other);
+    void decode_outputs(int8_t** output_bufs, std::vector<DetectResult>& results);
 };
 
 #endif // RKNN_DETECTOR_H
\ No newline at end of file
@@ -15,10 +15,19 @@ import logging
 
 from yolov5_rknn import RKNN_Inference
 
+# C++ 检测器的 Python 绑定 (CMake 加 -DBUILD_PYTHON_MODULE=ON 编译出 bricsbot_native.so)
+# 可用时解码和 NMS 走 C++ 的 int8 后处理，不可用时退回 numpy 后处理
+try:
+    import bricsbot_native
+    HAS_NATIVE = True
+except ImportError:
+    HAS_NATIVE = False
+
 HAS_DISPLAY = bool(os.environ.get("DISPLAY"))
 
 # yolov5配置参数 .yaml中的参数
 RKNN_MODEL = 'yolov5s.rknn'  # 请修改为你的RKNN模型路径
+LABEL_PATH = 'coco_80_labels_list.txt'  # C++ 检测器使用的标签文件
 IMG_WIDTH, IMG_HEIGHT = 640, 640 # 模型输入尺寸
 IMG_SIZE = 640
 OBJ_THRESH = 0.25
@@ -58,8 +67,20 @@ class ROSInterface:
         
         # 初始化CV Bridge
         self.bridge = CvBridge()
-        # 加载模型（原有逻辑）
-        self.rknn_lite = RKNN_Inference(RKNN_MODEL)
+        # 优先使用 C++ 检测器，加载失败时使用原有逻辑
+        self.native = None
+        if HAS_NATIVE:
+            detector = bricsbot_native.RKNNDetector()
+            if detector.init(RKNN_MODEL, LABEL_PATH) == 0:
+                detector.set_conf_threshold(OBJ_THRESH)
+                self.native = detector
+                # 模型输入直接写进 DMA 缓冲区，detect 时不再拷贝
+                self.frame_buf = bricsbot_native.DmaFrame(IMG_WIDTH, IMG_HEIGHT, 3)
+                self.frame_view = np.asarray(self.frame_buf)
+                self.resize_buf = np.empty((IMG_HEIGHT, IMG_WIDTH, 3), np.uint8)
+                rospy.loginfo("使用 C++ 检测器 (bricsbot_native)")
+        if self.native is None:
+            self.rknn_lite = RKNN_Inference(RKNN_MODEL)
         
         # ============== ROS话题定义 ==============
         # 发布者：带标注的图像
@@ -74,6 +95,38 @@ class ROSInterface:
         self.last_time = time.time()
         rospy.loginfo("YOLOv5 ROS接口已启动")
     
+    def infer(self, frame):
+        """
+        推理一帧，返回 (模型输入 RGB 图像, boxes, classes, scores)，没有目标时 boxes 为 None
+        """
+        if self.native is not None:
+            cv2.resize(frame, (IMG_WIDTH, IMG_HEIGHT), dst=self.resize_buf)
+            cv2.cvtColor(self.resize_buf, cv2.COLOR_BGR2RGB, dst=self.frame_view)
+            boxes, classes, scores = self.native.detect(self.frame_view)
+            if len(boxes) == 0:
+                boxes = None
+            return self.frame_view, boxes, classes, scores
+
+        # 调用原有推理逻辑
+        outputs = self.rknn_lite.run(frame)
+
+        # 调用原有后处理逻辑
+        input0_data = outputs[0]
+        input1_data = outputs[1]
+        input2_data = outputs[2]
+
+        input0_data = input0_data.reshape([3, -1] + list(input0_data.shape[-2:]))
+        input1_data = input1_data.reshape([3, -1] + list(input1_data.shape[-2:]))
+        input2_data = input2_data.reshape([3, -1] + list(input2_data.shape[-2:]))
+
+        input_data = list()
+        input_data.append(np.transpose(input0_data, (2, 3, 0, 1)))
+        input_data.append(np.transpose(input1_data, (2, 3, 0, 1)))
+        input_data.append(np.transpose(input2_data, (2, 3, 0, 1)))
+
+        boxes, classes, scores = self.rknn_lite.yolov5_post_process(input_data)
+        return self.rknn_lite.img_rgb, boxes, classes, scores
+
     def run(self):
         """
         ROS图像回调函数
@@ -97,28 +150,11 @@ class ROSInterface:
                     #print("无法读取摄像头帧")
                     break
             
-                # 2. 调用原有推理逻辑（完全不变）
+                # 2. 推理 + 后处理
                 start_time = time.time()
-                outputs = self.rknn_lite.run(frame)
+                img_rgb, boxes, classes, scores = self.infer(frame)
                 inference_time = (time.time() - start_time) * 1000
             
-                # 3. 调用原有后处理逻辑（完全不变）
-                input0_data = outputs[0]
-                input1_data = outputs[1]
-                input2_data = outputs[2]
-
-                input0_data = input0_data.reshape([3, -1] + list(input0_data.shape[-2:]))
-                input1_data = input1_data.reshape([3, -1] + list(input1_data.shape[-2:]))
-                input2_data = input2_data.reshape([3, -1] + list(input2_data.shape[-2:]))
-
-                input_data = list()
-                input_data.append(np.transpose(input0_data, (2, 3, 0, 1)))
-                input_data.append(np.transpose(input1_data, (2, 3, 0, 1)))
-                input_data.append(np.transpose(input2_data, (2, 3, 0, 1)))
-                
-                # 调用原有的后处理函数
-                boxes, classes, scores = self.rknn_lite.yolov5_post_process(input_data)
-            
                 # 4. 计算FPS
                 self.frame_count += 1
                 if frame_count >= 30:
@@ -127,9 +163,9 @@ class ROSInterface:
                     frame_count = 0
                     rospy.loginfo_throttle(f"FPS: {fps:.2f}, Inference: {inference_time:.2f}ms")
             
-                img_1 = cv2.cvtColor(self.rknn_lite.img_rgb, cv2.COLOR_RGB2BGR)
+                img_1 = cv2.cvtColor(img_rgb, cv2.COLOR_RGB2BGR)
                 if boxes is not None:
-                    self.rknn_lite.draw(img_1, boxes, scores, classes)
+                    RKNN_Inference.draw(img_1, boxes, scores, classes)
                     header = Header()
                     header.seq = self.frame_count
                     header.stamp = rospy.Time.now()
@@ -173,7 +209,8 @@ class ROSInterface:
             # 清理资源
             cap.release()
             cv2.destroyAllWindows()
-            self.rknn_lite.release()
+            if self.native is None:
+                self.rknn_lite.release()
   #          rospy.loginfo("摄像头已关闭，资源已释放")
     
 if __name__ == '__main__':
@@ -208,7 +208,8 @@ class RKNN_Inference:
         return boxes, classes, scores
     
     
-    def draw(self, image, boxes, scores, classes):
+    @staticmethod
+    def draw(image, boxes, scores, classes):
         """Draw the boxes on the image.
         # Argument:
             image: original image.
@@ -0,0 +1,130 @@
+#include "abr_controller.h"
+#include <algorithm>
+
+AbrController::AbrController(const AbrConfig& cfg)
+    : cfg(cfg), period_start(-1), busy_us(0), failures(0), max_queue(0.0f), loss(0.0f), jitter_ms(0.0f),
+      prev_loss(0.0f), prev_queue(0.0f), prev_jitter_ms(0.0f), up_count(0), down_count(0),
+      since_idr(cfg.idr_hold), idr_pending(false) {
+    state.bps = cfg.bps_max;
+    state.fps_divisor = 1;
+    state.scale_level = 0;
+    state.need_idr = false;
+}
+
+void AbrController::on_send(int64_t send_us, bool failed, float queue_ratio){
+    std::lock_guard<std::mutex> lk(mtx);
+    busy_us += send_us;
+    if(failed) failures++;
+    max_queue = std::max(max_queue, queue_ratio);
+}
+
+void AbrController::on_receiver_report(float loss, float jitter_ms){
+    std::lock_guard<std::mutex> lk(mtx);
+    // 一个周期内可能有多个客户端的报告，取最差的
+    this->loss = std::max(this->loss, loss);
+    this->jitter_ms = std::max(this->jitter_ms, jitter_ms);
+}
+
+/**
+ * @brief  到达评估周期时根据汇总的网络反馈调整码率、帧率和分辨率
+ * @param  now_us 当前时间 (微秒)
+ * @param  state  目标有变化时输出新的目标
+ * @return true 目标有变化，false 保持不变
+ * @remark 发送阻塞时间按周期长度归一化：链路带宽小于码率时，发送线程阻塞在发送缓冲区上的时间占比会持续升高。
+**/
+bool AbrController::update(int64_t now_us, AbrState& state){
+    std::lock_guard<std::mutex> lk(mtx);
+    if(period_start < 0){
+        period_start = now_us;
+        return false;
+    }
+    int64_t period_us = now_us - period_start;
+    if(period_us < (int64_t)cfg.interval_ms * 1000) return false;
+
+    float busy = (float)busy_us / period_us;
+    bool congested = failures > 0 || max_queue > cfg.queue_high || busy > cfg.busy_high ||
+                     loss > cfg.loss_high || jitter_ms > cfg.jitter_high_ms;
+    bool idle = failures == 0 && max_queue <= cfg.queue_low && busy <= cfg.busy_low &&
+                loss <= cfg.loss_low && jitter_ms <= cfg.jitter_low_ms;
+
+    AbrState next = this->state;
+    // 丢帧后接收端画面已损坏，但拥塞期间 IDR 本身也会加重拥塞：距上次 IDR 不足 idr_hold 个周期时先记下，
+    // 到期后 (此时码率已经按拥塞下调过) 再合并请求一次
+    if(failures > 0 || loss > cfg.loss_high) idr_pending = true;
+    since_idr++;
+    next.need_idr = idr_pending && since_idr >= cfg.idr_hold;
+    if(next.need_idr){
+        idr_pending = false;
+        since_idr = 0;
+    }
+
+    if(congested){
+        up_count = 0;
+        if(next.bps > cfg.bps_min){
+            next.bps = std::max(cfg.bps_min, (int)(next.bps * cfg.decrease));
+            down_count = 0;
+        }
+        else if(++down_count >= cfg.degrade_hold){
+            // 码率已到下限：先降帧率，最后才降分辨率
+            if(next.fps_divisor < cfg.max_fps_divisor) next.fps_divisor++;
+            else if(next.scale_level < cfg.max_scale_level) next.scale_level++;
+            down_count = 0;
+        }
+    }
+    else if(idle){
+        down_count = 0;
+        if(++up_count >= cfg.up_hold){
+            // 按降级的逆序恢复
+            if(next.scale_level > 0) next.scale_level--;
+            else if(next.fps_divisor > 1) next.fps_divisor--;
+            else next.bps = std::min(cfg.bps_max, next.bps + (int)(cfg.bps_max * cfg.increase));
+            up_count = 0;
+        }
+    }
+    else{
+        up_count = 0;
+        down_count = 0;
+    }
+
+    prev_loss = loss;
+    prev_queue = max_queue;
+    prev_jitter_ms = jitter_ms;
+    period_start = now_us;
+    busy_us = 0;
+    failures = 0;
+    max_queue = 0.0f;
+    loss = 0.0f;
+    jitter_ms = 0.0f;
+
+    bool changed = next.bps != this->state.bps || next.fps_divisor != this->state.fps_divisor ||
+                   next.scale_level != this->state.scale_level || next.need_idr;
+    this->state = next;
+    this->state.need_idr = false;
+    if(changed) state = next;
+    return changed;
+}
+
+float AbrController::scale_of(int level){
+    static const float scales[] = {1.0f, 0.75f, 0.5f};
+    return scales[std::min(std::max(level, 0), 2)];
+}
+
+AbrState AbrController::current() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return state;
+}
+
+float AbrController::last_loss() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return prev_loss;
+}
+
+float AbrController::last_queue() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return prev_queue;
+}
+
+float AbrController::last_jitter_ms() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return prev_jitter_ms;
+}
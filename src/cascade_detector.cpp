@@ -0,0 +1,87 @@
+#include "cascade_detector.h"
+#include <stdio.h>
+
+CascadeDetector::CascadeDetector(const CascadeConfig& cfg)
+    : cfg(cfg), since_heavy(0), ran_heavy(false), frames(0), heavy_frames(0) {
+}
+
+/**
+ * @brief  初始化级联检测器
+ * @param  light_model 轻量模型路径
+ * @param  heavy_model 重模型路径
+ * @param  label_path  类别名文件路径，两个模型需使用同一套类别
+ * @return 成功返回0，失败返回-1。
+**/
+int CascadeDetector::init(const std::string& light_model, const std::string& heavy_model,
+                          const std::string& label_path){
+    if(light.init(light_model, label_path) < 0) return -1;
+    if(heavy.init(heavy_model, label_path) < 0) return -1;
+
+    // 轻量模型放低阈值输出可疑候选，坐标统一到重模型输入尺寸
+    if(light.set_conf_threshold(cfg.light_conf) < 0) return -1;
+    light.set_output_size(heavy.model_width(), heavy.model_height());
+
+    // 保证第一帧就运行重模型
+    since_heavy = cfg.heavy_interval;
+    printf("Cascade: light %dx%d, heavy %dx%d, accept_conf=%.2f, heavy_interval=%d\n",
+           light.model_width(), light.model_height(), heavy.model_width(), heavy.model_height(),
+           cfg.accept_conf, cfg.heavy_interval);
+    return 0;
+}
+
+/**
+ * @brief  执行一帧级联推理
+ * @param  light_img 轻量模型输入图像
+ * @param  heavy_img 重模型输入图像
+ * @param  results   输出合并后的检测结果 (重模型输入图像坐标)
+ * @return 成功返回0，失败返回-1。
+ * @remark 重模型推理失败时退回只使用轻量模型的高置信度结果，不影响这一帧的输出。
+**/
+int CascadeDetector::inference(unsigned char* light_img, unsigned char* heavy_img, std::vector<DetectResult>& results){
+    if(light.inference(light_img, light_results) < 0) return -1;
+
+    frames++;
+    since_heavy++;
+    bool uncertain = false;
+    for(const auto& r : light_results){
+        if(r.confidence < cfg.accept_conf){
+            uncertain = true;
+            break;
+        }
+    }
+
+    ran_heavy = uncertain || (cfg.heavy_interval > 0 && since_heavy >= cfg.heavy_interval);
+    heavy_results.clear();
+    if(ran_heavy){
+        if(heavy.inference(heavy_img, heavy_results) < 0){
+            heavy_results.clear();
+            ran_heavy = false;
+        }
+        else{
+            since_heavy = 0;
+            heavy_frames++;
+        }
+    }
+
+    merge(results);
+    return 0;
+}
+
+/**
+ * @brief  合并两路结果：重模型结果全部保留，轻量模型只保留高置信度且未被重模型覆盖的框
+ * @remark 可疑候选 (置信度低于 accept_conf) 只作为触发条件，重模型没有确认就丢弃。
+**/
+void CascadeDetector::merge(std::vector<DetectResult>& results) const {
+    results = heavy_results;
+    for(const auto& l : light_results){
+        if(l.confidence < cfg.accept_conf) continue;
+        bool covered = false;
+        for(const auto& h : heavy_results){
+            if(h.id == l.id && detect_result_iou(h, l) > cfg.merge_iou){
+                covered = true;
+                break;
+            }
+        }
+        if(!covered) results.push_back(l);
+    }
+}
@@ -0,0 +1,203 @@
+#include "crop_classifier.h"
+#include "model_file.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <fstream>
+#include <algorithm>
+
+CropClassifier::CropClassifier() : ctx(0), batch(0), width(0), height(0), num_classes(0) {
+    batch_buf.fd = -1;
+    batch_buf.vaddr = nullptr;
+    batch_buf.size = 0;
+    memset(&batch_img, 0, sizeof(batch_img));
+}
+
+CropClassifier::~CropClassifier(){
+    if(batch_buf.fd >= 0) free_dma_buffer(&batch_buf);
+    if(ctx){
+        rknn_destroy(ctx);
+        ctx = 0;
+    }
+}
+
+/**
+ * @brief  加载分类模型并申请批量输入张量
+ * @param  model_path 模型文件路径
+ * @param  label_path 类别名文件路径
+ * @return 成功返回0，失败返回-1。
+**/
+int CropClassifier::init(const std::string& model_path, const std::string& label_path){
+    MappedFile model;
+    if(map_model_file(model_path.c_str(), &model) < 0) return -1;
+    int ret = rknn_init(&ctx, model.data, model.size, 0, NULL);
+    unmap_model_file(&model);
+    if(ret < 0){
+        printf("classifier rknn_init failed with error code: %d\n", ret);
+        return -1;
+    }
+    ret = rknn_query(ctx, RKNN_QUERY_IN_OUT_NUM, &io_num, sizeof(io_num));
+    if(ret < 0 || io_num.n_input != 1 || io_num.n_output < 1){
+        printf("classifier must have 1 input and at least 1 output\n");
+        return -1;
+    }
+
+    memset(&input_attr, 0, sizeof(input_attr));
+    memset(&output_attr, 0, sizeof(output_attr));
+    input_attr.index = 0;
+    output_attr.index = 0;
+    if(rknn_query(ctx, RKNN_QUERY_INPUT_ATTR, &input_attr, sizeof(input_attr)) < 0 ||
+       rknn_query(ctx, RKNN_QUERY_OUTPUT_ATTR, &output_attr, sizeof(output_attr)) < 0){
+        printf("classifier rknn_query attr failed\n");
+        return -1;
+    }
+
+    batch = std::max(1, (int)input_attr.dims[0]);
+    if(input_attr.fmt == RKNN_TENSOR_NCHW){
+        width = input_attr.dims[3];
+        height = input_attr.dims[2];
+    }
+    else{
+        width = input_attr.dims[2];
+        height = input_attr.dims[1];
+    }
+    num_classes = output_attr.n_elems / batch;
+
+    if(alloc_dma_buffer((size_t)batch * width * height * 3, &batch_buf) < 0){
+        printf("Classifier batch buffer alloc_dma_buffer failed\n");
+        return -1;
+    }
+    batch_img = wrapbuffer_fd(batch_buf.fd, width, height * batch, RK_FORMAT_RGB_888);
+
+    labels.clear();
+    std::ifstream lf(label_path);
+    std::string line;
+    while(lf && std::getline(lf, line)){
+        if(!line.empty() && line.back() == '\r') line.pop_back();
+        labels.push_back(line);
+    }
+    for(int i=(int)labels.size();i<num_classes;i++) labels.push_back(std::to_string(i));
+
+    printf("Crop classifier: batch %d, input %dx%d, %d classes\n", batch, width, height, num_classes);
+    return 0;
+}
+
+/**
+ * @brief  把检测框裁剪缩放进批量张量，所有裁剪放在同一个 RGA 任务里提交
+ * @param  frame 检测框坐标所在的图像 (RGB888)
+ * @param  boxes 检测框
+ * @return 裁剪数量，失败返回-1。
+**/
+int CropClassifier::prepare(const rga_buffer_t& frame, const std::vector<DetectResult>& boxes){
+    crop_boxes.clear();
+    crop_tracks.clear();
+
+    // 检测框多于批大小时优先分类置信度高的
+    std::vector<int> order;
+    for(size_t i=0;i<boxes.size();i++) order.push_back((int)i);
+    std::sort(order.begin(), order.end(), [&boxes](int a, int b){ return boxes[a].confidence > boxes[b].confidence; });
+
+    for(int idx : order){
+        if((int)crop_boxes.size() >= batch) break;
+        const DetectResult& b = boxes[idx];
+        int l = std::max(0, b.box.left), t = std::max(0, b.box.top);
+        int r = std::min(frame.width, b.box.right), btm = std::min(frame.height, b.box.bottom);
+        if(r - l < 2 || btm - t < 2) continue;     // RGA 不支持过小的源区域
+        crop_boxes.push_back(idx);
+        crop_tracks.push_back(b.track_id);
+    }
+    if(crop_boxes.empty()) return 0;
+
+    im_job_handle_t job = imbeginJob();
+    if(job <= 0){
+        printf("RGA imbeginJob failed\n");
+        crop_boxes.clear();
+        return -1;
+    }
+    rga_buffer_t pat;
+    memset(&pat, 0, sizeof(pat));
+    im_rect prect;
+    memset(&prect, 0, sizeof(prect));
+    for(size_t i=0;i<crop_boxes.size();i++){
+        const DetectResult& b = boxes[crop_boxes[i]];
+        im_rect srect, drect;
+        srect.x = std::max(0, b.box.left);
+        srect.y = std::max(0, b.box.top);
+        srect.width = std::min(frame.width, b.box.right) - srect.x;
+        srect.height = std::min(frame.height, b.box.bottom) - srect.y;
+        drect.x = 0;
+        drect.y = (int)i * height;
+        drect.width = width;
+        drect.height = height;
+        IM_STATUS status = improcessTask(job, frame, batch_img, pat, srect, drect, prect, NULL, 0);
+        if(status != IM_STATUS_SUCCESS){
+            printf("RGA improcessTask failed: %s\n", imStrError(status));
+            imcancelJob(job);
+            crop_boxes.clear();
+            return -1;
+        }
+    }
+    IM_STATUS status = imendJob(job);
+    if(status != IM_STATUS_SUCCESS){
+        printf("RGA imendJob failed: %s\n", imStrError(status));
+        crop_boxes.clear();
+        return -1;
+    }
+    return (int)crop_boxes.size();
+}
+
+/**
+ * @brief  对批量张量做一次推理，输出每个裁剪的最高分类别
+ * @param  results 输出分类结果，顺序与 prepare 时的裁剪顺序一致
+ * @return 成功返回0，失败返回-1。
+ * @remark 批量张量中未使用的槽位保留上一次的数据，对应的输出直接忽略。
+**/
+int CropClassifier::run(std::vector<ClassifyResult>& results){
+    results.clear();
+    if(crop_boxes.empty()) return 0;
+
+    rknn_input inputs[1];
+    memset(inputs, 0, sizeof(inputs));
+    inputs[0].index = 0;
+    inputs[0].buf = batch_buf.vaddr;
+    inputs[0].type = RKNN_TENSOR_UINT8;
+    inputs[0].fmt = RKNN_TENSOR_NHWC;
+    inputs[0].pass_through = 0;
+    inputs[0].size = (uint32_t)batch * width * height * 3;
+    rknn_inputs_set(ctx, 1, inputs);
+
+    int ret = rknn_run(ctx, nullptr);
+    if(ret < 0){
+        printf("classifier rknn_run failed with error code: %d\n", ret);
+        return -1;
+    }
+
+    rknn_output outputs[1];
+    memset(outputs, 0, sizeof(outputs));
+    outputs[0].index = 0;
+    outputs[0].want_float = 1;
+    ret = rknn_outputs_get(ctx, 1, outputs, NULL);
+    if(ret < 0){
+        printf("classifier rknn_outputs_get failed with error code: %d\n", ret);
+        return -1;
+    }
+
+    const float* logits = (const float*)outputs[0].buf;
+    for(size_t i=0;i<crop_boxes.size();i++){
+        const float* row = logits + i * num_classes;
+        int best = (int)(std::max_element(row, row + num_classes) - row);
+        // softmax 得到最高分类别的概率
+        float sum = 0.0f;
+        for(int c=0;c<num_classes;c++) sum += expf(row[c] - row[best]);
+
+        ClassifyResult r;
+        r.track_id = crop_tracks[i];
+        r.box_index = crop_boxes[i];
+        r.class_id = best;
+        r.name = labels[best];
+        r.score = 1.0f / sum;
+        results.push_back(r);
+    }
+    rknn_outputs_release(ctx, 1, outputs);
+    return 0;
+}
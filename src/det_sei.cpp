@@ -0,0 +1,187 @@
+#include "det_sei.h"
+#include <string.h>
+#include <algorithm>
+
+#define H264_NAL_SEI            6
+#define HEVC_NAL_PREFIX_SEI     39
+#define SEI_USER_DATA_UNREG     5
+
+// 本格式的 UUID，接收端据此区分其它 user_data_unregistered SEI
+static const uint8_t DET_SEI_UUID[16] = {
+    0x62, 0x72, 0x69, 0x63, 0x73, 0x62, 0x6f, 0x74, 0x2d, 0x64, 0x65, 0x74, 0x2d, 0x76, 0x31, 0x00
+};
+
+static void put_u16(std::vector<uint8_t>& out, uint32_t v){
+    out.push_back((uint8_t)(v >> 8));
+    out.push_back((uint8_t)v);
+}
+
+static void put_u32(std::vector<uint8_t>& out, uint32_t v){
+    put_u16(out, v >> 16);
+    put_u16(out, v & 0xFFFF);
+}
+
+static uint32_t get_u16(const uint8_t* p){
+    return ((uint32_t)p[0] << 8) | p[1];
+}
+
+static uint32_t get_u32(const uint8_t* p){
+    return (get_u16(p) << 16) | get_u16(p + 2);
+}
+
+static uint16_t clamp_u16(int v){
+    return (uint16_t)std::min(std::max(v, 0), 0xFFFF);
+}
+
+// SEI NAL 头的长度：H.264 为 1 字节，H.265 为 2 字节，不是 SEI NAL 返回 0
+static size_t sei_header_len(const uint8_t* nal, size_t len){
+    if(len >= 2 && (nal[0] & 0x1F) == H264_NAL_SEI) return 1;
+    if(len >= 3 && ((nal[0] >> 1) & 0x3F) == HEVC_NAL_PREFIX_SEI) return 2;
+    return 0;
+}
+
+void build_detection_sei(const DetectionSei& sei, std::vector<uint8_t>& nal, bool hevc){
+    const int count = std::min((int)sei.dets.size(), DET_SEI_MAX_DETS);
+
+    // SEI 负载：UUID + 检测结果
+    std::vector<uint8_t> payload(DET_SEI_UUID, DET_SEI_UUID + 16);
+    payload.reserve(16 + 14 + count * 16);
+    payload.push_back(DET_SEI_VERSION);
+    payload.push_back((uint8_t)count);
+    put_u32(payload, sei.frame_id);
+    put_u32(payload, (uint32_t)(sei.timestamp_us >> 32));
+    put_u32(payload, (uint32_t)sei.timestamp_us);
+    for(int i=0;i<count;i++){
+        const SeiDetection& d = sei.dets[i];
+        float conf = std::min(std::max(d.confidence, 0.0f), 1.0f);
+        put_u16(payload, clamp_u16(d.class_id));
+        put_u32(payload, (uint32_t)d.track_id);
+        put_u16(payload, (uint32_t)(conf * 65535.0f + 0.5f));
+        put_u16(payload, clamp_u16(d.left));
+        put_u16(payload, clamp_u16(d.top));
+        put_u16(payload, clamp_u16(d.right));
+        put_u16(payload, clamp_u16(d.bottom));
+    }
+
+    // RBSP：payloadType、payloadSize (0xFF 续接编码)、负载、rbsp_trailing_bits
+    std::vector<uint8_t> rbsp;
+    rbsp.reserve(payload.size() + 8);
+    rbsp.push_back(SEI_USER_DATA_UNREG);
+    size_t size = payload.size();
+    while(size >= 255){
+        rbsp.push_back(0xFF);
+        size -= 255;
+    }
+    rbsp.push_back((uint8_t)size);
+    rbsp.insert(rbsp.end(), payload.begin(), payload.end());
+    rbsp.push_back(0x80);
+
+    // 起始码 + NAL 头，RBSP 中连续两个 0 之后的 0~3 前插入防竞争字节 0x03
+    // H.265 NAL 头：forbidden_zero_bit、nal_unit_type (6 位)、nuh_layer_id = 0、nuh_temporal_id_plus1 = 1
+    nal.clear();
+    nal.reserve(rbsp.size() + rbsp.size() / 64 + 6);
+    const uint8_t start[4] = {0x00, 0x00, 0x00, 0x01};
+    nal.insert(nal.end(), start, start + 4);
+    if(hevc){
+        nal.push_back(HEVC_NAL_PREFIX_SEI << 1);
+        nal.push_back(0x01);
+    }
+    else{
+        nal.push_back(H264_NAL_SEI);
+    }
+    int zeros = 0;
+    for(uint8_t b : rbsp){
+        if(zeros >= 2 && b <= 0x03){
+            nal.push_back(0x03);
+            zeros = 0;
+        }
+        nal.push_back(b);
+        zeros = (b == 0x00) ? zeros + 1 : 0;
+    }
+}
+
+/**
+ * @brief  解析一个 SEI NAL (H.264 或 H.265)
+ * @param  nal  NAL 数据，从 NAL 头开始 (不含起始码)
+ * @param  len  NAL 长度
+ * @param  sei  输出的检测结果
+ * @return 0 成功，-1 不是检测结果 SEI 或数据损坏
+**/
+int parse_detection_sei(const uint8_t* nal, size_t len, DetectionSei& sei){
+    const size_t header = sei_header_len(nal, len);
+    if(header == 0) return -1;
+
+    // 去掉防竞争字节
+    std::vector<uint8_t> rbsp;
+    rbsp.reserve(len);
+    int zeros = 0;
+    for(size_t i=header;i<len;i++){
+        if(zeros >= 2 && nal[i] == 0x03){
+            zeros = 0;
+            continue;
+        }
+        rbsp.push_back(nal[i]);
+        zeros = (nal[i] == 0x00) ? zeros + 1 : 0;
+    }
+
+    // 去掉末尾的 0 (下一个 4 字节起始码的首字节)，最后一个字节为 rbsp_trailing_bits
+    while(!rbsp.empty() && rbsp.back() == 0x00) rbsp.pop_back();
+
+    // 一个 SEI NAL 可能包含多条消息，逐条查找
+    size_t pos = 0;
+    while(pos + 1 < rbsp.size()){
+        uint32_t type = 0, size = 0;
+        while(pos < rbsp.size() && rbsp[pos] == 0xFF) type += rbsp[pos++];
+        if(pos >= rbsp.size()) return -1;
+        type += rbsp[pos++];
+        while(pos < rbsp.size() && rbsp[pos] == 0xFF) size += rbsp[pos++];
+        if(pos >= rbsp.size()) return -1;
+        size += rbsp[pos++];
+        if(pos + size > rbsp.size()) return -1;
+
+        const uint8_t* p = rbsp.data() + pos;
+        pos += size;
+        if(type != SEI_USER_DATA_UNREG || size < 16 + 14 || memcmp(p, DET_SEI_UUID, 16) != 0) continue;
+
+        p += 16;
+        if(p[0] != DET_SEI_VERSION) return -1;
+        int count = p[1];
+        if(size < 16 + 14 + (uint32_t)count * 16) return -1;
+        sei.frame_id = get_u32(p + 2);
+        sei.timestamp_us = ((uint64_t)get_u32(p + 6) << 32) | get_u32(p + 10);
+        p += 14;
+        sei.dets.resize(count);
+        for(int i=0;i<count;i++, p+=16){
+            SeiDetection& d = sei.dets[i];
+            d.class_id = (int)get_u16(p);
+            d.track_id = (int32_t)get_u32(p + 2);
+            d.confidence = get_u16(p + 6) / 65535.0f;
+            d.left = (int)get_u16(p + 8);
+            d.top = (int)get_u16(p + 10);
+            d.right = (int)get_u16(p + 12);
+            d.bottom = (int)get_u16(p + 14);
+        }
+        return 0;
+    }
+    return -1;
+}
+
+int find_detection_sei(const uint8_t* data, size_t len, DetectionSei& sei){
+    size_t i = 0;
+    while(i + 3 < len){
+        if(data[i] != 0x00 || data[i + 1] != 0x00 || data[i + 2] != 0x01){
+            i++;
+            continue;
+        }
+        size_t start = i + 3;
+        // 找下一个起始码确定 NAL 的结尾
+        size_t end = start;
+        while(end + 2 < len && !(data[end] == 0x00 && data[end + 1] == 0x00 && data[end + 2] == 0x01)) end++;
+        if(end + 2 >= len) end = len;
+        if(sei_header_len(data + start, end - start) > 0 && parse_detection_sei(data + start, end - start, sei) == 0){
+            return 0;
+        }
+        i = end;
+    }
+    return -1;
+}
@@ -0,0 +1,31 @@
+#include "encoded_frame.h"
+
+// 返回 pos 之后第一个 00 00 01 起始码的位置，没有返回 len
+static size_t find_start_code(const uint8_t* p, size_t pos, size_t len){
+    for(size_t i=pos;i+2<len;i++){
+        if(p[i] == 0x00 && p[i + 1] == 0x00 && p[i + 2] == 0x01) return i;
+    }
+    return len;
+}
+
+void split_nal_units(const EncodedFrame& frame, std::vector<EncodedSpan>& nals){
+    nals.clear();
+    for(const auto& span : frame.spans){
+        const uint8_t* p = span.data.get();
+        size_t start = find_start_code(p, 0, span.len);
+        while(start < span.len){
+            size_t begin = start + 3;
+            size_t next = find_start_code(p, begin, span.len);
+            size_t end = next;
+            // 4 字节起始码的首个 0 以及 NAL 末尾的 trailing_zero_8bits 不属于当前 NAL
+            while(end > begin && p[end - 1] == 0x00) end--;
+            if(end > begin){
+                EncodedSpan nal;
+                nal.data = std::shared_ptr<uint8_t>(span.data, span.data.get() + begin);
+                nal.len = end - begin;
+                nals.push_back(nal);
+            }
+            start = next;
+        }
+    }
+}
@@ -18,29 +18,39 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <map>
+#include <future>
 #include <pthread.h>
 #include <sched.h>
+#include <signal.h>
 #include <unistd.h>
 
-// opencv相关
-#include <opencv2/opencv.hpp>
-
 // Rockchip SDK 相关
 #include "im2d.h"
 #include "rga.h"
 #include "dma_utils.h"
 #include "mpp_encoder.h"
 #include "yolo_detector.h"
+#include "tracker.h"
+#include "motion_gate.h"
+#include "cascade_detector.h"
+#include "tiled_detector.h"
+#include "resolution_policy.h"
+#include "npu_scheduler.h"
+#include "crop_classifier.h"
+#include "nv12_overlay.h"
+#include "det_sei.h"
+#include "abr_controller.h"
 
 // RTSP库
 #include "xop/RtspServer.h"
 #include "xop/H264Source.h"
+#include "xop/H265Source.h"
 
 // 辅助函数
 #include "count_utils.h"
 #include "udp_utils.h"
 #include "v4l2_utils.h"
-#include "frame_pool.h"
 
 
 #define VIDEO_DEVICE        "/dev/video0"       // 摄像头设备路径
@@ -49,9 +59,60 @@
 #define DEST_IP             "192.168.13.10"     // 目标IP地址
 #define DEST_PORT           8888                // 目标端口号
 #define _Capability_Query   0                   // 定义该宏以启用设备能力查询功能
-#define _USE_OPENCV_DRAW    1                   // 定义该宏以启用OPENCV绘制检测框
+#define _DRAW_BOXES         (_USE_FFMPEG_ENCODER || !_USE_DETECTION_SEI)    // 定义该宏以把检测框画进画面；默认只在没有 SEI 的情况下画 (FFmpeg 软件编码不插入 SEI)，否则检测结果只通过 SEI 传输，由接收端绘制
+#define _USE_DETECTION_SEI  1                   // 定义该宏以在每帧码流中插入检测结果 SEI (MPP 编码时生效)
+#define _USE_OPENCV_DRAW    0                   // 定义该宏以启用OPENCV绘制检测框 (调试用，需要安装 OpenCV)
+#define _USE_NV12_OVERLAY   1                   // 定义该宏以在编码器的 NV12 缓冲区上直接绘制检测框和标签 (MPP 编码时生效)
 #define _USE_PURE_UDP       1                   // 定义该宏以启用裸UDP分发
 #define _USE_FFMPEG_ENCODER 1                   // MPP异常时使用FFmpeg软件编码推流
+#define _USE_ASYNC_ENCODER  1                   // 定义该宏以使用异步编码：提交与取包分离，VPU 编码与下一帧的推理并行 (MPP 编码时生效)
+#define ENC_QUEUE_DEPTH     2                   // 异步编码时最多同时在编码器中的帧数
+#define _USE_HEVC           0                   // 定义该宏以使用 H.265 编码 (MPP 编码时生效)：同等画质码率低 30%~50%，接收端需按 H.265 解码 (如 ffmpeg -f hevc)
+#define ENC_BITRATE         2500000             // MPP 编码目标码率 (bit/s)，CBR，其余参数见 inc/mpp_encoder.h 的 MppEncoderConfig
+#define ENC_GOP             60                  // MPP 编码 I 帧间隔 (帧)
+#define ENC_SLICE_BYTES     1000                // >0 时按该字节数划分条带，编码器每完成一个条带就立即发送 (略小于 UDP_MTU / RTP 负载上限，一个条带基本一个包)；0 为整帧编码、整帧发送
+#define _USE_ROI_ENCODING   1                   // 定义该宏以按检测框 (含跟踪预测框) 做 ROI 编码：目标区域降低 QP、背景提高 QP (MPP 编码时生效)
+#define ROI_QP_DELTA        -6                  // ROI 编码时目标区域的 QP 偏移
+#define ROI_BG_QP_DELTA     3                   // ROI 编码时背景的 QP 偏移
+#define _USE_ABR            1                   // 定义该宏以根据网络反馈 (发送队列、发送失败、RTCP 丢包/抖动) 自动调整码率、帧率和分辨率 (MPP 编码时生效)
+#define ABR_MIN_BITRATE     500000              // 码率自适应的码率下限 (bit/s)，上限为 ENC_BITRATE
+#define _CAPTURE_TENSORS    0                   // 定义该宏以录制NPU原始输出张量 (供 postprocess_bench 离线评测)
+#define CAPTURE_DIR         "../capture"        // 张量录制目录
+#define CAPTURE_FRAMES      300                 // 最多录制的帧数
+#define DETECT_INTERVAL     1                   // 每隔多少帧运行一次NPU推理，其余帧由跟踪器预测检测框
+#define _USE_MOTION_GATE    1                   // 定义该宏以启用运动门控：画面静止时跳过NPU推理
+#define MOTION_DIFF_THRESH  12                  // 运动门控灵敏度：缩略图像素亮度差阈值
+#define MOTION_MIN_RATIO    0.002f              // 运动门控灵敏度：变化像素占比阈值
+#define _USE_CASCADE        0                   // 定义该宏以启用两级级联检测：轻量模型每帧运行，重模型按需运行
+#define LIGHT_MODEL_PATH    "../model/yolov5n-320-320.rknn" // 级联检测的轻量模型
+#define HEAVY_MODEL_PATH    "../model/yolov5s-640-640.rknn" // 主检测模型 (级联时为重模型)
+#define _USE_TILED          0                   // 定义该宏以启用分块推理：原始分辨率的帧切块检测，适合高分辨率摄像头下的小目标
+#define TILE_MODEL_PATH     "../model/yolov5s-640-640.rknn" // 分块推理使用的模型，分块大小等于模型输入尺寸
+#define _USE_DYNAMIC_SHAPE  0                   // 定义该宏以按推理耗时和画面复杂度切换动态输入模型的输入尺寸 (需用动态 shape 导出 HEAVY_MODEL_PATH)
+#define LATENCY_BUDGET_MS   25.0f               // 动态输入尺寸策略的单帧推理耗时预算
+#define _USE_CLASSIFIER     0                   // 定义该宏以对检测框做二级分类 (如鱼类品种)，检测器与分类器由 NPU 调度器统一调度
+#define CLS_MODEL_PATH      "../model/species_cls.rknn"     // 分类模型，输入 [N, H, W, 3]
+#define CLS_LABEL_PATH      "../model/species_labels.txt"   // 分类类别名
+#define CLS_DEADLINE_MS     100                 // 分类任务的截止时间，NPU 繁忙超过该时间未执行就丢弃
+#define MODEL_SWAP_FILE     "../model/swap_model.txt"       // 收到 SIGUSR1 时从该文件第一行读取新模型路径并热切换
+
+#if _USE_OPENCV_DRAW
+// opencv相关
+#include <opencv2/opencv.hpp>
+#endif
+
+// 编码输入缓冲区个数：异步编码时，一帧在编码器中的同时要往另一块缓冲区写下一帧
+#if _USE_ASYNC_ENCODER
+#define ENC_BUF_COUNT       (ENC_QUEUE_DEPTH + 1)
+#else
+#define ENC_BUF_COUNT       1
+#endif
+
+// 热切换请求：kill -USR1 <pid> 触发，主循环在帧间处理
+static volatile sig_atomic_t g_swap_request = 0;
+static void on_swap_signal(int){
+    g_swap_request = 1;
+}
 
 bool set_cpu_governor_performance(const std::vector<int>& target_cores) {
     bool success = true;
@@ -104,6 +165,12 @@ bool bind_thread_to_cores(const std::vector<int>& target_cores) {
     return true;
 }
 
+static void free_dma_buffers(struct DmaBuffer *bufs, int count){
+    for(int i=0;i<count;i++){
+        free_dma_buffer(&bufs[i]);
+    }
+}
+
 #if _USE_FFMPEG_ENCODER
 FILE *start_ffmpeg_encoder()
 {
@@ -151,7 +218,9 @@ int main(int argc, char *argv[]){
     StageStat s_get{"v4l2_get"};
     StageStat s_rga1{"rga_yuyv2rgb"};
     StageStat s_npu{"npu_infer"};
-    StageStat s_opencv{"draw_box"};
+    StageStat s_track{"track"};
+    StageStat s_motion{"motion_gate"};
+    StageStat s_draw{"draw_box"};
     StageStat s_rga2{"rga_rgb2nv12"};
     StageStat s_enc{"mpp_encode"};
     StageStat s_push{"rtsp_push"};
@@ -164,16 +233,67 @@ int main(int argc, char *argv[]){
 
     //bind_thread_to_cores(big_cores);
 
+    // 启动时间线：相互独立的子系统并行初始化，缩短上电到第一帧的时间
+    //   后台线程：V4L2 摄像头、每个 NPU 模型 (各自独立的 rknn 上下文)
+    //   主线程：  网络 (UDP/RTSP)、DMA 内存、编码器
+    // 各子系统的对象先在这里构造，初始化失败统一在汇合点处理；std::async 的 future 析构时会等待线程结束
+    StartupTimeline timeline;
+
     // 初始化V4L2，打开摄像头设备，设置分辨率和帧率，申请缓冲区并映射到用户空间
     V4L2Context v4l2_ctx;
-    if(v4l2_init(&v4l2_ctx, VIDEO_DEVICE) < 0){
-        printf("Failed to initialize V4L2\n");
-        return -1;
-    }
+    std::future<int> v4l2_ready = std::async(std::launch::async, [&]() {
+        int64_t ts = now_us();
+        int r = v4l2_init(&v4l2_ctx, VIDEO_DEVICE);
+        timeline.add("v4l2", ts);
+        return r;
+    });
 
-#if _Capability_Query
-    // 查询视频设备能力，列出支持的像素格式、分辨率和帧率
-    v4l2_capability_query(v4l2_ctx.fd);
+#if _USE_CASCADE
+    CascadeDetector cascade;
+    RKNNDetector& detector = cascade.heavy_detector();
+#else
+    RKNNDetector detector;
+#endif
+    std::future<int> detector_ready = std::async(std::launch::async, [&]() {
+        int64_t ts = now_us();
+#if _USE_CASCADE
+        int r = cascade.init(LIGHT_MODEL_PATH, HEAVY_MODEL_PATH);
+#else
+        int r = detector.init(HEAVY_MODEL_PATH);
+#endif
+        timeline.add("rknn_detector", ts);
+        return r;
+    });
+
+#if _USE_TILED
+    // 分块推理直接读取摄像头原始帧，每个 NPU 核心加载一份模型
+    TiledDetector tiled;
+    std::future<int> tiled_ready = std::async(std::launch::async, [&]() {
+        int64_t ts = now_us();
+        int r = tiled.init(TILE_MODEL_PATH, SRC_WIDTH, SRC_HEIGHT);
+        timeline.add("rknn_tiled", ts);
+        return r;
+    });
+#endif
+
+#if _USE_CLASSIFIER
+    CropClassifier classifier;
+    std::future<int> classifier_ready = std::async(std::launch::async, [&]() {
+        int64_t ts = now_us();
+        int r = classifier.init(CLS_MODEL_PATH, CLS_LABEL_PATH);
+        timeline.add("rknn_classifier", ts);
+        return r;
+    });
+#endif
+
+    int64_t ts_net = now_us();
+
+#if _USE_ABR && !_USE_FFMPEG_ENCODER
+    // 码率自适应控制器：发送端和 RTCP 的反馈在各自的线程上报，主循环每帧检查一次
+    AbrConfig abr_cfg;
+    abr_cfg.bps_max = ENC_BITRATE;
+    abr_cfg.bps_min = ABR_MIN_BITRATE;
+    AbrController abr(abr_cfg);
 #endif
 
 #if _USE_FFMPEG_ENCODER
@@ -195,8 +315,18 @@ int main(int argc, char *argv[]){
     }
     // 3. 创建一个叫 "live" 的流媒体会话 (推流地址就是 rtsp://ip:8554/live)
     xop::MediaSession* session = xop::MediaSession::CreateNew("live");
-    // 4. 添加 H.264 视频源通道
+    // 4. 添加视频源通道 (H.264 / H.265，与编码格式一致)
+#if _USE_HEVC
+    session->AddSource(xop::channel_0, xop::H265Source::CreateNew());
+#else
     session->AddSource(xop::channel_0, xop::H264Source::CreateNew());
+#endif
+#if _USE_ABR
+    // 客户端的 RTCP 接收者报告：丢包率为 8 位定点数，抖动为 90kHz 时间戳单位
+    session->AddNotifyReceiverReportCallback([&abr](xop::MediaSessionId, const xop::RtcpReceiverReport& report){
+        abr.on_receiver_report(report.fraction_lost / 256.0f, report.jitter / 90.0f);
+    });
+#endif
     // session->AddNotifyConnectedCallback([] (xop::MediaSessionId sessionId, std::string peer_ip, uint16_t peer_port){
     //     printf("有 PC 客户端连接进来了: %s\n", peer_ip.c_str());
     // });
@@ -211,15 +341,24 @@ int main(int argc, char *argv[]){
     printf("RTSP Server is running at rtsp://192.168.13.11:8554/live\n");
 
 #endif
+    timeline.add("network", ts_net);
 
+    int64_t ts_dma = now_us();
 #if !_USE_FFMPEG_ENCODER
-    // 申请一块DMA内存给MPP用 MPP需要NV12 大小 W*H*1.5
+    // 申请DMA内存给MPP用 MPP需要NV12 大小 W*H*1.5，异步编码时多块轮流使用
     size_t mpp_size = DST_HEIGHT * DST_WIDTH * 3 / 2;
-    struct DmaBuffer mpp_buf = {-1, NULL, 0};
-    if(alloc_dma_buffer(mpp_size, &mpp_buf) < 0) {
-        perror("MPP buffer alloc_dma_buffer failed");
-        return -1;
+    struct DmaBuffer mpp_bufs[ENC_BUF_COUNT];
+    for(int i=0;i<ENC_BUF_COUNT;i++){
+        mpp_bufs[i] = {-1, NULL, 0};
     }
+    for(int i=0;i<ENC_BUF_COUNT;i++){
+        if(alloc_dma_buffer(mpp_size, &mpp_bufs[i]) < 0) {
+            perror("MPP buffer alloc_dma_buffer failed");
+            free_dma_buffers(mpp_bufs, ENC_BUF_COUNT);
+            return -1;
+        }
+    }
+    int enc_buf_idx = 0;
 #endif
 
     // 申请一块内存给NPU用 NPU需要RGB888 大小 W*H*3
@@ -228,7 +367,7 @@ int main(int argc, char *argv[]){
     if (alloc_dma_buffer(npu_size, &npu_buf)<0) {
         perror("NPU buffer alloc_dma_buffer failed");
 #if !_USE_FFMPEG_ENCODER
-        free_dma_buffer(&mpp_buf);
+        free_dma_buffers(mpp_bufs, ENC_BUF_COUNT);
 #endif
         return -1;
     }
@@ -238,11 +377,10 @@ int main(int argc, char *argv[]){
     memset(&src_img, 0, sizeof(src_img));
     memset(&infer_img, 0, sizeof(infer_img));
     memset(&dst_img, 0, sizeof(dst_img));
-#if !_USE_FFMPEG_ENCODER
-    dst_img = wrapbuffer_fd(mpp_buf.fd, DST_WIDTH, DST_HEIGHT, RK_FORMAT_YCbCr_420_SP);
-#endif
     infer_img = wrapbuffer_fd(npu_buf.fd, DST_WIDTH, DST_HEIGHT, RK_FORMAT_RGB_888);
+    timeline.add("dma_buffers", ts_dma);
 
+    int64_t ts_enc = now_us();
 #if _USE_FFMPEG_ENCODER
     FILE *ffmpeg_pipe = start_ffmpeg_encoder();
     if(!ffmpeg_pipe){
@@ -252,37 +390,262 @@ int main(int argc, char *argv[]){
 #else
     MppEncoder encoder;
     // 初始化摄像头分辨率 30fps
-    if(encoder.init(DST_WIDTH,DST_HEIGHT,30) < 0){
+    MppEncoderConfig enc_cfg;
+    enc_cfg.fps = 30;
+#if _USE_HEVC
+    enc_cfg.coding = MPP_VIDEO_CodingHEVC;
+#endif
+    enc_cfg.gop = ENC_GOP;
+    enc_cfg.bps_target = ENC_BITRATE;
+    enc_cfg.bps_min = ENC_BITRATE * 4 / 5;
+    enc_cfg.bps_max = ENC_BITRATE * 6 / 5;
+    enc_cfg.roi_qp_delta = ROI_QP_DELTA;
+    enc_cfg.roi_bg_qp_delta = ROI_BG_QP_DELTA;
+#if ENC_SLICE_BYTES > 0
+    enc_cfg.split_mode = MPP_ENC_SPLIT_BY_BYTE;
+    enc_cfg.split_arg = ENC_SLICE_BYTES;
+    enc_cfg.slice_output = true;
+#endif
+    if(encoder.init(DST_WIDTH,DST_HEIGHT,enc_cfg) < 0){
         printf("MPP Failed to initialize encoder\n");
         free_dma_buffer(&npu_buf);
-        free_dma_buffer(&mpp_buf);
+        free_dma_buffers(mpp_bufs, ENC_BUF_COUNT);
         return -1;
     }
+    // 编码输入缓冲区在启动时导入一次，之后每帧直接复用
+    for(int i=0;i<ENC_BUF_COUNT;i++){
+        encoder.import_buffer(mpp_bufs[i].fd, mpp_bufs[i].size);
+    }
 #endif
+    timeline.add("encoder", ts_enc);
 
-    RKNNDetector detector;
-    if(detector.init("../model/yolov5s-640-640.rknn") < 0){
+    // 汇合点：等待后台初始化完成
+    if(v4l2_ready.get() < 0){
+        printf("Failed to initialize V4L2\n");
+#if _USE_FFMPEG_ENCODER
+        pclose(ffmpeg_pipe);
+        free_dma_buffer(&npu_buf);
+#else
+        free_dma_buffer(&npu_buf);
+        free_dma_buffers(mpp_bufs, ENC_BUF_COUNT);
+#endif
+        return -1;
+    }
+
+#if _Capability_Query
+    // 查询视频设备能力，列出支持的像素格式、分辨率和帧率
+    v4l2_capability_query(v4l2_ctx.fd);
+#endif
+
+    ret = detector_ready.get();
+#if _USE_TILED
+    if(tiled_ready.get() < 0){
+        printf("Failed to initialize TiledDetector\n");
+        ret = -1;
+    }
+#endif
+#if _USE_CLASSIFIER
+    if(classifier_ready.get() < 0){
+        printf("Failed to initialize CropClassifier\n");
+        ret = -1;
+    }
+#endif
+    timeline.report();
+    if(ret < 0){
         printf("Failed to initialize RKNNDetector\n");
 #if _USE_FFMPEG_ENCODER
         pclose(ffmpeg_pipe);
         free_dma_buffer(&npu_buf);
 #else
         free_dma_buffer(&npu_buf);
-        free_dma_buffer(&mpp_buf);
+        free_dma_buffers(mpp_bufs, ENC_BUF_COUNT);
+#endif
+        return -1;
+    }
+
+#if _CAPTURE_TENSORS
+    detector.set_capture(CAPTURE_DIR, CAPTURE_FRAMES);
+#endif
+
+#if _USE_CLASSIFIER
+    // NPU 调度：检测器优先级最高且不设截止时间，分类器低优先级，过期的分类任务直接丢弃
+    NpuScheduler npu_sched;
+    int det_model = npu_sched.register_model("detector", 10, 0);
+    int cls_model = npu_sched.register_model("classifier", 1, CLS_DEADLINE_MS);
+    npu_sched.start();
+    std::future<int> cls_future;
+    std::vector<ClassifyResult> cls_results;
+    std::map<int, std::string> species;     // 跟踪编号 -> 分类结果
 #endif
+
+#if _USE_DYNAMIC_SHAPE
+    // 模型输入尺寸随策略变化，检测框统一输出在 infer_img 坐标下；
+    // 输入尺寸与 infer_img 不同时由 RGA 缩放到单独的一块内存 (按最大一档申请)
+    ResolutionPolicyConfig policy_cfg;
+    policy_cfg.latency_budget_ms = LATENCY_BUDGET_MS;
+    ResolutionPolicy res_policy(policy_cfg);
+    res_policy.set_sizes(detector.supported_input_sizes(), detector.model_width(), detector.model_height());
+    if(!detector.is_dynamic()){
+        printf("Warning: model has a fixed input shape, dynamic input size policy disabled\n");
+    }
+    detector.set_output_size(DST_WIDTH, DST_HEIGHT);
+    struct DmaBuffer model_buf = {-1, NULL, 0};
+    rga_buffer_t model_img;
+    memset(&model_img, 0, sizeof(model_img));
+    if(alloc_dma_buffer(detector.model_width() * detector.model_height() * 3, &model_buf) < 0){
+        perror("Model input buffer alloc_dma_buffer failed");
+        free_dma_buffer(&npu_buf);
         return -1;
     }
+#endif
+
+#if _USE_CASCADE
+    // 轻量模型输入尺寸与 infer_img 不同时单独申请一块输入内存，每帧由 RGA 从 infer_img 缩放得到
+    RKNNDetector& light_det = cascade.light_detector();
+    bool light_resize = light_det.model_width() != DST_WIDTH || light_det.model_height() != DST_HEIGHT;
+    struct DmaBuffer light_buf = {-1, NULL, 0};
+    rga_buffer_t light_img;
+    memset(&light_img, 0, sizeof(light_img));
+    if(light_resize){
+        if(alloc_dma_buffer(light_det.model_width() * light_det.model_height() * 3, &light_buf) < 0){
+            perror("Light model buffer alloc_dma_buffer failed");
+            free_dma_buffer(&npu_buf);
+            return -1;
+        }
+        light_img = wrapbuffer_fd(light_buf.fd, light_det.model_width(), light_det.model_height(), RK_FORMAT_RGB_888);
+    }
+#endif
 
+#if _DRAW_BOXES && _USE_OPENCV_DRAW
     // 调试用：Mat对象指向npu_buf虚拟地址
     cv::Mat orig_img(DST_HEIGHT, DST_WIDTH, CV_8UC3, npu_buf.vaddr);
     cv::Mat show_img(DST_HEIGHT, DST_WIDTH, CV_8UC3);
+#endif
 
-    // rtsp内存池创建
-    FramePool rtsp_pool(2 * 1024 * 1024, 6); // 2MB块大小，预分配6块
+#if _DRAW_BOXES && _USE_NV12_OVERLAY && !_USE_FFMPEG_ENCODER
+    // NV12 叠加层：RGA 转出编码器输入后直接在上面画框和标签
+    Nv12Overlay overlay;
+    const OverlayColor box_color = overlay_color(0, 255, 0);
+    const OverlayColor text_color = overlay_color(255, 255, 255);
+    const OverlayColor label_color = overlay_color(0, 128, 0);
+#endif
+
+    // 跟踪器：关联相邻帧的检测框并在不推理的帧上预测框的位置
+    ObjectTracker tracker;
+
+    // 运动门控：画面与上次推理时相比没有变化就沿用上一次的检测结果
+    MotionGate motion_gate;
+    motion_gate.set_sensitivity(MOTION_DIFF_THRESH, MOTION_MIN_RATIO);
+    std::vector<DetectResult> last_results;
+
+#if !_USE_FFMPEG_ENCODER
+    // 发送时复用的 NAL / iovec 列表
+    std::vector<EncodedSpan> rtsp_nals;
+    std::vector<struct iovec> udp_iov;
+    int sent_cnt = 0;
+    // 条带输出时一帧分多次发送：同一帧的条带共用 RTP 时间戳，发送耗时累加到帧结束
+    bool frame_open = false;
+    uint32_t rtsp_ts = 0;
+    size_t frame_bytes = 0;
+    int64_t frame_push_us = 0;
+    // 发送线程 (异步编码时为编码器输出线程) 也会更新的统计项
+    std::mutex stat_mtx;
+    StageStat s_enc_lat{"enc_latency"};
+
+    // 发送一帧 (或一帧中的若干条带) 编码输出：同步编码时在主线程调用，异步编码时在编码器输出线程调用
+    auto send_encoded = [&](EncodedFrame& frame){
+        // 空的部分只在需要结束一帧时处理
+        if(frame.size == 0 && (!frame.last || !frame_open)) return;
+        int64_t tp0 = now_us();
+        if(!frame_open){
+            frame_open = true;
+            rtsp_ts = xop::H264Source::GetTimestamp(); // 同一访问单元的 NAL 使用相同的时间戳 (90kHz，H.264/H.265 相同)
+            frame_bytes = 0;
+            frame_push_us = 0;
+        }
+        frame_bytes += frame.size;
+#if _USE_PURE_UDP
+        // 网络发送代码：各片段直接聚合发送
+        udp_iov.resize(frame.spans.size());
+        for(size_t i=0;i<frame.spans.size();i++){
+            udp_iov[i].iov_base = frame.spans[i].data.get();
+            udp_iov[i].iov_len = frame.spans[i].len;
+        }
+        int send_ret = udp_sendv(&udp_ctx, udp_iov.data(), (int)udp_iov.size());
+#if _USE_ABR
+        // 发送耗时 (阻塞在发送缓冲区上的时间)、是否丢弃了分片、发送后的队列占用率
+        int queued = udp_queued_bytes(&udp_ctx);
+        float queue_ratio = (queued > 0 && udp_ctx.sndbuf > 0) ? (float)queued / udp_ctx.sndbuf : 0.0f;
+        abr.on_send(now_us() - tp0, send_ret < 0, queue_ratio);
+#else
+        (void)send_ret;
+#endif
+#else
+        // 按 NAL 推送给 RTSP 库 (它会自动进行 RTP 分包和发送)，帧数据以引用的方式传递，
+        // 各客户端发送完成后 MPP 包才被释放
+        split_nal_units(frame, rtsp_nals);
+        for(const auto& nal : rtsp_nals){
+            xop::AVFrame videoFrame(0);
+            videoFrame.type = 0; // 0 代表视频，1 代表音频
+            videoFrame.size = (uint32_t)nal.len;
+            videoFrame.timestamp = rtsp_ts;
+            videoFrame.buffer = nal.data;
+            // 把这一帧推送到 "live" 这个通道
+            server->PushFrame(session_id, xop::channel_0, videoFrame);
+        }
+        rtsp_nals.clear();
+#endif
+        int64_t tp1 = now_us();
+        frame_push_us += tp1 - tp0;
+        if(!frame.last) return;
+        frame_open = false;
+#if _USE_PURE_UDP
+        printf("Frame %d encoded: %zu bytes\n", sent_cnt, frame_bytes);
+#endif
+        sent_cnt++;
+        std::lock_guard<std::mutex> lk(stat_mtx);
+        s_push.add(frame_push_us);
+    };
+
+#if _USE_ASYNC_ENCODER
+    // 异步编码：主线程只提交，码流由编码器输出线程取出后直接发送
+    if(encoder.start_async(ENC_QUEUE_DEPTH, [&](EncodedFrame& frame, int64_t latency_us){
+        // 条带输出时以最后一个条带的时间作为编码时延
+        if(frame.last){
+            std::lock_guard<std::mutex> lk(stat_mtx);
+            s_enc_lat.add(latency_us);
+        }
+        send_encoded(frame);
+    }) < 0){
+        printf("MPP Failed to start async encoder\n");
+        free_dma_buffer(&npu_buf);
+        free_dma_buffers(mpp_bufs, ENC_BUF_COUNT);
+        return -1;
+    }
+#endif
+#endif
+
+    signal(SIGUSR1, on_swap_signal);
 
     while(1)
     {
+#if _USE_FFMPEG_ENCODER
         static int frame_cnt = 0;
+#endif
+        static int capture_cnt = 0;    // 采集帧计数，用于决定本帧是否推理
+
+        // 模型热切换：后台加载，加载完成后检测器在某次推理开始时自动切换，不中断采集和推流
+        if(g_swap_request){
+            g_swap_request = 0;
+            std::ifstream swap_file(MODEL_SWAP_FILE);
+            std::string new_model;
+            if(std::getline(swap_file, new_model) && !new_model.empty()){
+                detector.load_model_async(new_model);
+            }
+            else{
+                printf("Model swap: no model path in %s\n", MODEL_SWAP_FILE);
+            }
+        }
 
         int64_t t0 = now_us();
 
@@ -298,6 +661,14 @@ int main(int argc, char *argv[]){
             continue;
         }
 
+#if _USE_MOTION_GATE
+        int64_t tm0 = now_us();
+        bool scene_changed = motion_gate.should_infer(src_ptr, SRC_WIDTH, SRC_HEIGHT);
+        s_motion.add(now_us() - tm0);
+#else
+        bool scene_changed = true;
+#endif
+
         int64_t tr10 = now_us();
         // RGA 进行格式转换和缩放，输入 src_ptr (YUYV422)，输出 infer_img (RGB888)
         src_img = wrapbuffer_virtualaddr(src_ptr, SRC_WIDTH, SRC_HEIGHT, RK_FORMAT_YUYV_422);
@@ -311,14 +682,108 @@ int main(int argc, char *argv[]){
             continue;
         }
 
-        // 执行推理
+        // 执行推理 (每 DETECT_INTERVAL 帧一次)，跟踪器给检测框分配稳定的编号
         std::vector<DetectResult> results;
-        int64_t tn0 = now_us();
-        int ret = detector.inference((unsigned char*)npu_buf.vaddr, results);
-        int64_t tn1 = now_us();
-        s_npu.add(tn1 - tn0);
+        int ret = 0;
+        bool interval_hit = (capture_cnt++ % DETECT_INTERVAL == 0);
+        if(interval_hit && scene_changed){
+            int64_t tn0 = now_us();
+            // 检测器推理 (级联/分块/动态尺寸等模式都在这里)，ret 为推理结果
+            auto run_detector = [&]() -> int {
+#if _USE_CASCADE
+                unsigned char* light_ptr = (unsigned char*)npu_buf.vaddr;
+                if(light_resize){
+                    if(imresize(infer_img, light_img) == IM_STATUS_SUCCESS){
+                        light_ptr = (unsigned char*)light_buf.vaddr;
+                    }
+                    else{
+                        printf("RGA light model resize failed\n");
+                        light_ptr = nullptr;
+                    }
+                }
+                ret = light_ptr ? cascade.inference(light_ptr, (unsigned char*)npu_buf.vaddr, results) : -1;
+#elif _USE_TILED
+                // 分块结果为原始帧坐标，换算到 infer_img 坐标后再叠加
+                ret = tiled.inference(src_img, results);
+                for(auto& r : results){
+                    r.box.left = r.box.left * DST_WIDTH / SRC_WIDTH;
+                    r.box.right = r.box.right * DST_WIDTH / SRC_WIDTH;
+                    r.box.top = r.box.top * DST_HEIGHT / SRC_HEIGHT;
+                    r.box.bottom = r.box.bottom * DST_HEIGHT / SRC_HEIGHT;
+                }
+#elif _USE_DYNAMIC_SHAPE
+                unsigned char* model_ptr = (unsigned char*)npu_buf.vaddr;
+                if(detector.model_width() != DST_WIDTH || detector.model_height() != DST_HEIGHT){
+                    model_img = wrapbuffer_fd(model_buf.fd, detector.model_width(), detector.model_height(), RK_FORMAT_RGB_888);
+                    if(imresize(infer_img, model_img) == IM_STATUS_SUCCESS){
+                        model_ptr = (unsigned char*)model_buf.vaddr;
+                    }
+                    else{
+                        printf("RGA model input resize failed\n");
+                        model_ptr = nullptr;
+                    }
+                }
+                ret = model_ptr ? detector.inference(model_ptr, results) : -1;
+                InputSize next_size;
+                if(ret == 0 && res_policy.update(now_us() - tn0, results, next_size)){
+                    // 只有检测器真正切换成功，策略才更新当前档位
+                    if(detector.set_input_size(next_size.width, next_size.height) == 0) res_policy.commit();
+                    else res_policy.reject();
+                }
+#else
+                ret = detector.inference((unsigned char*)npu_buf.vaddr, results);
+#endif
+                return ret;
+            };
+#if _USE_CLASSIFIER
+            // 检测器以最高优先级经调度器执行，分类任务积压时也不会被拖慢
+            ret = npu_sched.submit(det_model, run_detector).get();
+#else
+            ret = run_detector();
+#endif
+            int64_t tn1 = now_us();
+            s_npu.add(tn1 - tn0);
+#if _USE_MOTION_GATE
+            // 只有真正推理过的帧才作为运动门控的参考帧
+            if(ret == 0) motion_gate.mark_inferred();
+#endif
 
-#if _USE_OPENCV_DRAW
+            int64_t tt0 = now_us();
+            if(ret == 0) tracker.update(results);
+            s_track.add(now_us() - tt0);
+            last_results = results;
+
+#if _USE_CLASSIFIER
+            // 上一批分类完成后，按本帧检测框一次性批量裁剪，分类以低优先级交给调度器异步执行，结果按跟踪编号保存
+            if(cls_future.valid() && cls_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready){
+                if(cls_future.get() == 0){
+                    if(species.size() > 2 * OBJ_NUMB_MAX_SIZE) species.clear();
+                    for(const auto& c : cls_results){
+                        if(c.track_id >= 0) species[c.track_id] = c.name;
+                    }
+                }
+            }
+            if(ret == 0 && !results.empty() && !cls_future.valid()){
+                if(classifier.prepare(infer_img, results) > 0){
+                    cls_future = npu_sched.submit(cls_model, [&classifier, &cls_results]() -> int {
+                        return classifier.run(cls_results);
+                    });
+                }
+            }
+#endif
+        }
+        else if(!scene_changed){
+            // 画面静止：沿用上一次的检测结果
+            results = last_results;
+        }
+        else{
+            // 没有推理的帧：用跟踪器预测框的位置
+            int64_t tt0 = now_us();
+            tracker.predict(results);
+            s_track.add(now_us() - tt0);
+        }
+
+#if _DRAW_BOXES && _USE_OPENCV_DRAW
         // 使用OpenCV将推理结果绘制到原图上
         dma_sync_cpu(npu_buf.fd);
 
@@ -331,18 +796,23 @@ int main(int argc, char *argv[]){
                     //       res.id, res.name.c_str(), res.confidence,
                     //       res.box.left, res.box.top, res.box.right, res.box.bottom);
                     cv::rectangle(orig_img, cv::Point(res.box.left, res.box.top), cv::Point(res.box.right, res.box.bottom), cv::Scalar(0, 255, 0), 3);
-                    cv::putText(orig_img, res.name, cv::Point(res.box.left, res.box.top + 12), cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(255, 255, 255));
+                    std::string text = res.track_id >= 0 ? res.name + " #" + std::to_string(res.track_id) : res.name;
+#if _USE_CLASSIFIER
+                    auto sp = species.find(res.track_id);
+                    if(sp != species.end()) text += " " + sp->second;
+#endif
+                    cv::putText(orig_img, text, cv::Point(res.box.left, res.box.top + 12), cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(255, 255, 255));
                 }
                 int64_t td1 = now_us();
-                s_opencv.add(td1 - td0);
+                s_draw.add(td1 - td0);
             }
         }else{
             printf("RKNN inference failed with error code: %d\n", ret);
         }
 
         dma_sync_device(npu_buf.fd);
-#else
-        // 使用RGA将推理结果绘制到原图上
+#elif _DRAW_BOXES && (!_USE_NV12_OVERLAY || _USE_FFMPEG_ENCODER)
+        // 使用RGA将推理结果绘制到原图上 (FFmpeg 推流时没有 NV12 缓冲区，叠加层不可用)
         if(ret==0 && !results.empty()){
             printf("=============================================================\n");
             
@@ -383,6 +853,37 @@ int main(int argc, char *argv[]){
             break;
         }
 #else
+#if _USE_ABR
+        // 码率自适应：每个评估周期根据网络反馈调整一次码率、帧率和分辨率
+        {
+            AbrState abr_state;
+            if(abr.update(now_us(), abr_state)){
+                enc_cfg.bps_target = abr_state.bps;
+                enc_cfg.bps_min = abr_state.bps * 4 / 5;
+                enc_cfg.bps_max = abr_state.bps * 6 / 5;
+                enc_cfg.fps = 30 / abr_state.fps_divisor;
+                encoder.reconfigure(enc_cfg);
+                // 分辨率按 16 对齐，编码输入缓冲区不变，RGA 直接缩放到新尺寸
+                float scale = AbrController::scale_of(abr_state.scale_level);
+                encoder.resize((int)(DST_WIDTH * scale) & ~15, (int)(DST_HEIGHT * scale) & ~15);
+                if(abr_state.need_idr) encoder.request_idr();
+                printf("[ABR] bitrate=%d fps=%d size=%dx%d%s\n", abr_state.bps, enc_cfg.fps,
+                       encoder.get_width(), encoder.get_height(), abr_state.need_idr ? " idr" : "");
+            }
+            // 降帧率：每 fps_divisor 帧只编码一帧
+            if(capture_cnt % abr.current().fps_divisor != 0){
+                v4l2_release_frame(&v4l2_ctx);
+                continue;
+            }
+        }
+#endif
+        // 本帧使用的编码输入缓冲区 (异步编码时轮流使用，前几帧可能还在编码器中)
+        struct DmaBuffer& mpp_buf = mpp_bufs[enc_buf_idx];
+        // 编码尺寸可能被码率自适应缩小，检测框坐标 (DST 坐标系) 按比例换算到编码画面
+        const int enc_w = encoder.get_width();
+        const int enc_h = encoder.get_height();
+        dst_img = wrapbuffer_fd(mpp_buf.fd, enc_w, enc_h, RK_FORMAT_YCbCr_420_SP);
+
         int64_t tr20 = now_us();
         status = imresize(infer_img, dst_img);
         int64_t tr21 = now_us();
@@ -394,44 +895,103 @@ int main(int argc, char *argv[]){
             continue;
         }
 
-        // 编码 NV12 数据，得到 H264 码流
-        void *h264_data = NULL;
-        size_t h264_len = 0;
+#if _DRAW_BOXES && _USE_NV12_OVERLAY && !_USE_OPENCV_DRAW
+        // 在 NV12 编码缓冲区上绘制检测框和标签：只写框线和标签所在的行，不读取帧内容
+        if(ret == 0 && !results.empty()){
+            int64_t td0 = now_us();
+            // 框线和标签行只覆盖部分 Cache 行，开始写之前必须先失效 Cache，
+            // 否则残留的旧 Cache 行被写脏后刷回，会用上一帧的像素覆盖 RGA 刚写入的内容
+            dma_sync_cpu(mpp_buf.fd);
+            overlay.begin((uint8_t*)mpp_buf.vaddr, enc_w, enc_h);
+            char text[64];
+            for(const auto& res : results){
+                std::string name = res.name;
+#if _USE_CLASSIFIER
+                auto sp = species.find(res.track_id);
+                if(sp != species.end()) name += " " + sp->second;
+#endif
+                if(res.track_id >= 0){
+                    snprintf(text, sizeof(text), "%s #%d %.2f", name.c_str(), res.track_id, res.confidence);
+                }
+                else{
+                    snprintf(text, sizeof(text), "%s %.2f", name.c_str(), res.confidence);
+                }
+                int left = res.box.left * enc_w / DST_WIDTH;
+                int top = res.box.top * enc_h / DST_HEIGHT;
+                overlay.draw_box(left, top, res.box.right * enc_w / DST_WIDTH, res.box.bottom * enc_h / DST_HEIGHT, box_color);
+                // 标签放在框上方，放不下时放在框内
+                int label_y = top - overlay.label_height();
+                if(label_y < 0) label_y = top;
+                overlay.draw_label(left, label_y, text, text_color, label_color);
+            }
+            dma_sync_device(mpp_buf.fd);
+            s_draw.add(now_us() - td0);
+        }
+#endif
+
+#if _USE_DETECTION_SEI
+        // 检测结果随这一帧的码流发送，时间戳为 V4L2 采集时间
+        {
+            DetectionSei sei;
+            sei.frame_id = (uint32_t)capture_cnt;
+            sei.timestamp_us = (uint64_t)v4l2_ctx.buffer.timestamp.tv_sec * 1000000ULL + v4l2_ctx.buffer.timestamp.tv_usec;
+            sei.dets.reserve(results.size());
+            for(const auto& res : results){
+                SeiDetection d;
+                d.class_id = res.id;
+                d.track_id = res.track_id;
+                d.confidence = res.confidence;
+                d.left = res.box.left * enc_w / DST_WIDTH;
+                d.top = res.box.top * enc_h / DST_HEIGHT;
+                d.right = res.box.right * enc_w / DST_WIDTH;
+                d.bottom = res.box.bottom * enc_h / DST_HEIGHT;
+                sei.dets.push_back(d);
+            }
+            std::vector<unsigned char> sei_nal;
+            build_detection_sei(sei, sei_nal, encoder.is_hevc());
+            encoder.set_sei(sei_nal);
+        }
+#endif
+
+#if _USE_ROI_ENCODING
+        // 这一帧的检测框作为 ROI，码率集中到目标上，背景少分配码率
+        if(!results.empty()){
+            std::vector<RoiBox> roi;
+            roi.reserve(results.size());
+            for(const auto& res : results){
+                RoiBox box;
+                box.left = res.box.left * enc_w / DST_WIDTH;
+                box.top = res.box.top * enc_h / DST_HEIGHT;
+                box.right = res.box.right * enc_w / DST_WIDTH;
+                box.bottom = res.box.bottom * enc_h / DST_HEIGHT;
+                roi.push_back(box);
+            }
+            encoder.set_roi(roi);
+        }
+#endif
 
+#if _USE_ASYNC_ENCODER
+        // 提交给编码器后立即返回，队列满时才等待
         int64_t te0 = now_us();
-        int enc_ok = encoder.encode(mpp_buf.fd, &h264_data, &h264_len) == 0;
+        int enc_ok = encoder.submit(mpp_buf.fd) == 0;
         int64_t te1 = now_us();
         s_enc.add(te1 - te0);
-
-        if(enc_ok){
-#if _USE_PURE_UDP
-            if(h264_len > 0){
-                // 网络发送代码
-                printf("Frame %d encoded: %zu bytes\n", frame_cnt++, h264_len);
-                udp_send(&udp_ctx, h264_data, h264_len);
-            }
+        enc_buf_idx = (enc_buf_idx + 1) % ENC_BUF_COUNT;
+        if(!enc_ok){
+            printf("MPP Failed to submit frame\n");
+        }
 #else
-            if (h264_len > 0) {
-                xop::AVFrame videoFrame = {0};
-                videoFrame.type = 0; // 0 代表视频，1 代表音频
-                videoFrame.size = h264_len;
-                videoFrame.timestamp = xop::H264Source::GetTimestamp(); // 自动打时间戳
-                int64_t tp0 = now_us();
-                // 拷贝数据给 RTSP 库 (它会自动进行 RTP 分包和发送)
-                //videoFrame.buffer.reset(new uint8_t[videoFrame.size]);
-                videoFrame.buffer = rtsp_pool.acquire(videoFrame.size); // 从内存池获取一块内存
-                memcpy(videoFrame.buffer.get(), h264_data, videoFrame.size);
-                //printf("Frame %d encoded: %zu bytes\n", frame_cnt++, h264_len);
-                
-                // 把这一帧推送到 "live" 这个通道
-                server->PushFrame(session_id, xop::channel_0, videoFrame);
-                int64_t tp1 = now_us();
-                s_push.add(tp1 - tp0);
-            }
-#endif
-        } else{
+        // 编码 NV12 数据，得到 H.264/H.265 码流 (引用 MPP 包内存的片段，不拷贝)，回调返回后即释放对 MPP 包的引用
+        // 条带输出时每完成一个条带就在回调中发送，mpp_encode 统计中包含这些条带的发送时间
+        int64_t te0 = now_us();
+        int enc_ok = encoder.encode(mpp_buf.fd, [&](EncodedFrame& part){ send_encoded(part); }) == 0;
+        int64_t te1 = now_us();
+        s_enc.add(te1 - te0);
+
+        if(!enc_ok){
             printf("MPP Failed to encode frame\n");
         }
+#endif
 #endif
 
         // 入队
@@ -440,6 +1000,14 @@ int main(int argc, char *argv[]){
         int64_t t1 = now_us();
         s_total.add(t1 - t0);
 
+        static bool first_frame = true;
+        if(first_frame){
+            // 上电到第一帧送出的时间
+            timeline.add("first_frame", t0);
+            timeline.report();
+            first_frame = false;
+        }
+
         stat_frames++;
         if (stat_frames >= 60) {
             printf("--------------------------------------------------\n");
@@ -448,11 +1016,55 @@ int main(int argc, char *argv[]){
                 double mx  = (double)s.max_us / 1000.0;
                 printf("[LAT] %-12s avg=%7.2f ms max=%7.2f ms\n", s.name, avg, mx);
             };
-            pr(s_get); pr(s_rga1); pr(s_npu); pr(s_opencv); pr(s_rga2); pr(s_enc); pr(s_push); pr(s_total);
+            pr(s_get); pr(s_motion); pr(s_rga1); pr(s_npu); pr(s_track); pr(s_draw); pr(s_rga2); pr(s_enc);
+#if !_USE_FFMPEG_ENCODER
+            {
+                std::lock_guard<std::mutex> lk(stat_mtx);
+#if _USE_ASYNC_ENCODER
+                pr(s_enc_lat);
+#endif
+                pr(s_push);
+                s_enc_lat.reset(); s_push.reset();
+            }
+#else
+            pr(s_push);
+#endif
+            pr(s_total);
+#if _USE_ABR && !_USE_FFMPEG_ENCODER
+            {
+                AbrState st = abr.current();
+                printf("[ABR] bitrate=%d fps=1/%d scale=%.2f queue=%.2f loss=%.3f jitter=%.1f ms\n", st.bps, st.fps_divisor,
+                       AbrController::scale_of(st.scale_level), abr.last_queue(), abr.last_loss(), abr.last_jitter_ms());
+            }
+#endif
+#if _USE_MOTION_GATE
+            printf("[GATE] skip rate=%5.1f%% last changed=%.4f\n",
+                   motion_gate.hit_rate() * 100.0f, motion_gate.last_changed_ratio());
+            motion_gate.reset_stats();
+#endif
+#if _USE_CASCADE
+            printf("[CASCADE] heavy model rate=%5.1f%%\n", cascade.heavy_rate() * 100.0f);
+            cascade.reset_stats();
+#endif
+#if _USE_CLASSIFIER
+            npu_sched.report_stats();
+#endif
+#if _USE_DYNAMIC_SHAPE
+            printf("[DYN] input=%dx%d avg infer=%.2f ms switches=%d\n", detector.model_width(), detector.model_height(),
+                   res_policy.avg_latency_ms(), res_policy.switch_count());
+#endif
+#if _USE_TILED
+            const TiledStats& ts = tiled.last_stats();
+            printf("[TILED] tiles=%d crop=%.2f ms infer=%.2f ms wall=%.2f ms nms=%.2f ms\n", ts.tiles,
+                   ts.crop_us / 1000.0, ts.infer_us / 1000.0, ts.wall_us / 1000.0, ts.nms_us / 1000.0);
+#endif
             printf("--------------------------------------------------\n");
 
-            s_get.reset(); s_rga1.reset(); s_npu.reset(); s_opencv.reset(); s_rga2.reset();
-            s_enc.reset(); s_push.reset(); s_total.reset();
+            s_get.reset(); s_motion.reset(); s_rga1.reset(); s_npu.reset(); s_track.reset(); s_draw.reset(); s_rga2.reset();
+            s_enc.reset(); s_total.reset();
+#if _USE_FFMPEG_ENCODER
+            s_push.reset();
+#endif
             stat_frames = 0;
         }
 
@@ -463,10 +1075,25 @@ int main(int argc, char *argv[]){
     pclose(ffmpeg_pipe);
     free_dma_buffer(&npu_buf);
 #else
-    free_dma_buffer(&mpp_buf);
+    encoder.stop_async();
+    for(int i=0;i<ENC_BUF_COUNT;i++){
+        encoder.release_buffer(mpp_bufs[i].fd);
+    }
+    free_dma_buffers(mpp_bufs, ENC_BUF_COUNT);
     free_dma_buffer(&npu_buf);
 #endif
 
+#if _USE_CASCADE
+    if(light_resize) free_dma_buffer(&light_buf);
+#endif
+#if _USE_DYNAMIC_SHAPE
+    free_dma_buffer(&model_buf);
+#endif
+#if _USE_CLASSIFIER
+    if(cls_future.valid()) cls_future.wait();
+    npu_sched.stop();
+#endif
+
     v4l2_deinit(&v4l2_ctx);
     //close(udp_ctx.socket_fd);
     return 0;
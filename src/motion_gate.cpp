@@ -0,0 +1,126 @@
+#include "motion_gate.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MOTION_GATE_NEON 1
+#else
+#define MOTION_GATE_NEON 0
+#endif
+
+MotionGate::MotionGate(const MotionGateConfig& cfg)
+    : cfg(cfg), has_ref(false), skip_run(0), changed_ratio(0.0f), total(0), skipped(0) {
+    thumb.resize(cfg.thumb_w * cfg.thumb_h);
+    ref.resize(cfg.thumb_w * cfg.thumb_h);
+}
+
+void MotionGate::set_sensitivity(int diff_thresh, float min_changed_ratio){
+    cfg.diff_thresh = diff_thresh;
+    cfg.min_changed_ratio = min_changed_ratio;
+}
+
+/**
+ * @brief  YUYV 亮度分块平均缩小到 thumb_w x thumb_h
+ * @remark 先纵向把 by 行的 Y 累加到 col_acc (u16，by <= 257 不会溢出)，再横向按 bx 求块平均。
+ *         纵向累加覆盖全部像素，是主要开销，NEON 下一次处理 16 个像素。
+**/
+void MotionGate::downscale_luma(const unsigned char* yuyv, int width, int height, int stride){
+    const int bx = width / cfg.thumb_w;
+    const int by = height / cfg.thumb_h;
+    const int used_w = bx * cfg.thumb_w;
+    const int div = bx * by;
+    col_acc.resize(used_w);
+
+    for(int ty=0;ty<cfg.thumb_h;ty++){
+        uint16_t* acc = col_acc.data();
+        memset(acc, 0, used_w * sizeof(uint16_t));
+        for(int r=0;r<by;r++){
+            const unsigned char* row = yuyv + (size_t)(ty * by + r) * stride;
+            int x = 0;
+#if MOTION_GATE_NEON
+            for(;x+16<=used_w;x+=16){
+                uint8x16x2_t yuv = vld2q_u8(row + x * 2);   // val[0] 为 16 个 Y
+                uint16x8_t lo = vaddw_u8(vld1q_u16(acc + x), vget_low_u8(yuv.val[0]));
+                uint16x8_t hi = vaddw_u8(vld1q_u16(acc + x + 8), vget_high_u8(yuv.val[0]));
+                vst1q_u16(acc + x, lo);
+                vst1q_u16(acc + x + 8, hi);
+            }
+#endif
+            for(;x<used_w;x++){
+                acc[x] += row[x * 2];
+            }
+        }
+
+        uint8_t* out = thumb.data() + ty * cfg.thumb_w;
+        for(int tx=0;tx<cfg.thumb_w;tx++){
+            uint32_t sum = 0;
+            for(int k=0;k<bx;k++) sum += acc[tx * bx + k];
+            out[tx] = (uint8_t)(sum / div);
+        }
+    }
+}
+
+// 统计与参考帧相比亮度差超过 diff_thresh 的像素数
+int MotionGate::count_changed() const {
+    const int n = (int)thumb.size();
+    const uint8_t* a = thumb.data();
+    const uint8_t* b = ref.data();
+    int count = 0;
+    int i = 0;
+#if MOTION_GATE_NEON
+    uint8x16_t thr = vdupq_n_u8((uint8_t)cfg.diff_thresh);
+    uint16x8_t acc = vdupq_n_u16(0);
+    for(;i+16<=n;i+=16){
+        uint8x16_t diff = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        uint8x16_t mask = vcgtq_u8(diff, thr);
+        acc = vpadalq_u8(acc, vshrq_n_u8(mask, 7));
+    }
+    uint16_t lanes[8];
+    vst1q_u16(lanes, acc);
+    for(int k=0;k<8;k++) count += lanes[k];
+#endif
+    for(;i<n;i++){
+        int d = (int)a[i] - (int)b[i];
+        if(d > cfg.diff_thresh || -d > cfg.diff_thresh) count++;
+    }
+    return count;
+}
+
+/**
+ * @brief  判断当前帧是否需要推理
+ * @param  yuyv   YUYV422 图像数据
+ * @param  width  图像宽度
+ * @param  height 图像高度
+ * @param  stride 每行字节数，0 表示 width*2
+ * @return true 需要推理 (画面有变化、没有参考帧或已连续 max_skip 帧没有推理)，false 可以沿用上一次的检测结果
+ * @remark 只和最近一次推理成功的帧比较，参考帧由 mark_inferred() 更新
+**/
+bool MotionGate::should_infer(const unsigned char* yuyv, int width, int height, int stride){
+    if(stride <= 0) stride = width * 2;
+    if(width < cfg.thumb_w || height < cfg.thumb_h) return true;
+
+    downscale_luma(yuyv, width, height, stride);
+    total++;
+
+    bool infer = true;
+    if(has_ref){
+        changed_ratio = (float)count_changed() / thumb.size();
+        infer = changed_ratio > cfg.min_changed_ratio || skip_run >= cfg.max_skip;
+    }
+
+    // 推理成功时 mark_inferred() 会清零
+    skip_run++;
+    if(!infer) skipped++;
+    return infer;
+}
+
+/**
+ * @brief  本帧推理成功：最近一次 should_infer() 计算的缩略图成为新的参考帧
+ * @remark 必须在同一帧的 should_infer() 之后调用
+**/
+void MotionGate::mark_inferred(){
+    ref.swap(thumb);
+    has_ref = true;
+    skip_run = 0;
+}
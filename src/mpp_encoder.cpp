@@ -1,18 +1,58 @@
 #include "mpp_encoder.h"
+#include "count_utils.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 
 static int align_up(int value, int align)
 {
     return (value + align - 1) & ~(align - 1);
 }
 
+// NAL 类型：H.264 为首字节低 5 位，H.265 为 2 字节 NAL 头首字节的第 1~6 位
+static int nal_type(const unsigned char *nal, bool hevc)
+{
+    return hevc ? (nal[0] >> 1) & 0x3F : nal[0] & 0x1F;
+}
+
+// 图像条带 NAL：H.264 类型 1~5，H.265 类型 0~31 (VCL)
+static bool is_slice_nal(int type, bool hevc)
+{
+    return hevc ? type < 32 : (type >= 1 && type <= 5);
+}
+
+// 随机访问点：H.264 IDR (类型 5)，H.265 IRAP (BLA/IDR/CRA，类型 16~23)
+static bool is_irap_nal(int type, bool hevc)
+{
+    return hevc ? (type >= 16 && type <= 23) : type == 5;
+}
+
+// 查找第一个图像条带 NAL 的起始码位置 (4 字节起始码时指向开头的 00)，没有返回 -1
+static long find_first_slice(const unsigned char *ptr, size_t len, bool hevc)
+{
+    for (size_t i = 0; i + 3 < len; i++) {
+        if (ptr[i] == 0x00 && ptr[i+1] == 0x00 && ptr[i+2] == 0x01) {
+            if (is_slice_nal(nal_type(ptr + i + 3, hevc), hevc)) {
+                return (i > 0 && ptr[i-1] == 0x00) ? (long)i - 1 : (long)i;
+            }
+            i += 2;
+        }
+    }
+    return -1;
+}
+
 /*   
-    MppEncoder 类实现了基于 Rockchip MPP 的 H.264 视频编码功能。它提供了初始化编码器、编码帧数据和释放资源的接口。
+    MppEncoder 类实现了基于 Rockchip MPP 的 H.264 / H.265 视频编码功能 (由 MppEncoderConfig::coding 选择)。它提供了初始化编码器、编码帧数据和释放资源的接口。
     主要成员函数包括：
-    - init(int width, int height, int fps)：初始化编码器，设置视频宽高和帧率。
-    - encode(int dma_fd, void **out_data, size_t *out_len)：编码一帧数据，输入为 RGA 转换好的 NV12 数据的 DMA FD，输出为 H.264 码流指针和长度。
+    - init(int width, int height, int fps) / init(int width, int height, const MppEncoderConfig &config)：初始化编码器，设置视频宽高、帧率和码率控制参数。
+    - reconfigure(const MppEncoderConfig &config)：运行中修改码率、GOP、QP 等参数，不重建编码上下文。
+    - resize(int width, int height) / request_idr()：运行中修改分辨率、请求 IDR (码率自适应使用)。
+    - encode(int dma_fd, EncodedFrame &out)：编码一帧数据，输入为 RGA 转换好的 NV12 数据的 DMA FD，输出为引用 MPP 包内存的 Annex B 码流片段。
+    - encode(int dma_fd, const SliceCallback &on_slice)：同上，开启条带输出 (split:out) 时每编码完一个条带就交付一次，不等整帧。
+    - start_async(int queue_depth, PacketCallback callback) / submit(int dma_fd) / stop_async()：异步模式，提交与取包分离到不同线程，码流通过回调输出。
+    - set_roi(const std::vector<RoiBox> &boxes)：按检测框设置下一帧的 ROI，目标区域降低 QP、背景提高 QP (通过 frame meta 逐帧生效)。
+    - import_buffer(int dma_fd, size_t size) / release_buffer(int dma_fd)：输入 DMA 缓冲区按 fd 导入一次并缓存，MppFrame 随缓存项复用。
     - deinit()：释放编码器资源。
 
     内部使用 MPP API 创建编码上下文，配置编码参数，并管理输入帧和输出码流的缓冲区。调用者需要在使用 encode() 前先调用 init()，并在不需要编码时调用 deinit() 释放资源。
@@ -22,38 +62,49 @@ static int align_up(int value, int align)
 MppEncoder::MppEncoder()
     : width(0),
       height(0),
+      coding(MPP_VIDEO_CodingAVC),
       ctx(NULL),
       mpi(NULL),
       buf_grp(NULL),
-      packet_buf(NULL),
-      packet_buf_size(0) {
+      queue_depth(0),
+      async_running(false),
+      slice_out(false) {
+    memset(&roi_cfg, 0, sizeof(roi_cfg));
 }
 
 MppEncoder::~MppEncoder() {
     deinit();
 }
 
+int MppEncoder::init(int width, int height, int fps){
+    MppEncoderConfig config;
+    config.fps = fps;
+    return init(width, height, config);
+}
+
 /**  
  * @brief   初始化编码器
  * @param   width   视频宽度
  * @param   height  视频高度
- * @param   fps     视频帧率
+ * @param   config  编码参数 (帧率、码率控制、GOP、QP、profile/level)
  * @return  0 成功，-1 失败
  * @remark  该函数会创建 MPP 上下文，配置编码参数，并分配必要的缓冲区资源。调用者在使用 encode() 前必须调用此函数进行初始化。
  *          如果初始化失败，调用者应该检查返回值并进行相应的错误处理。
  *          成功初始化后，编码器将准备好接受帧数据进行编码。
  *          该函数内部会设置编码参数，如码率控制模式、目标码率、帧率等，以适应网络传输的需求。
 **/
-int MppEncoder::init(int width, int height, int fps){
+int MppEncoder::init(int width, int height, const MppEncoderConfig &config){
 
     this->width = width;
     this->height = height;
+    this->coding = config.coding;
+    const bool hevc = is_hevc();
     const int hor_stride = align_up(width, 16);
     const int ver_stride = align_up(height, 16);
     MPP_RET ret = MPP_OK;
 
-    // 创建MPP上下文：编码器 H.264
-    printf("Initializing MPP encoder: %dx%d @ %dfps...\n", width, height, fps);
+    // 创建MPP上下文：编码器 H.264 / H.265
+    printf("Initializing MPP %s encoder: %dx%d @ %dfps...\n", hevc ? "H.265" : "H.264", width, height, config.fps);
     fflush(stdout);
 
     printf("[MPP] mpp_create...\n");
@@ -66,10 +117,10 @@ int MppEncoder::init(int width, int height, int fps){
     printf("[MPP] mpp_create ok, ctx=%p, mpi=%p\n", ctx, mpi);
     fflush(stdout);
 
-    // 分配具体任务：编码 ENC , 编码格式 H.264
+    // 分配具体任务：编码 ENC , 编码格式 H.264 / H.265
     printf("[MPP] mpp_init encoder...\n");
     fflush(stdout);
-    ret = mpp_init(ctx, MPP_CTX_ENC, MPP_VIDEO_CodingAVC);
+    ret = mpp_init(ctx, MPP_CTX_ENC, coding);
     if (ret != MPP_OK) {
         fprintf(stderr, "mpp_init failed, ret=%d\n", ret);
         mpp_destroy(ctx);
@@ -80,14 +131,6 @@ int MppEncoder::init(int width, int height, int fps){
     printf("[MPP] mpp_init ok\n");
     fflush(stdout);
 
-    // 预分配拼包内存：2MB
-    packet_buf_size = 2 * 1024 * 1024;
-    packet_buf = (char*)malloc(packet_buf_size);
-    if(!packet_buf){
-        fprintf(stderr, "malloc packet_buf failed\n");
-        return -1;
-    }
-
     // 设置编码参数
     MppEncCfg cfg = NULL;
     ret = mpp_enc_cfg_init(&cfg);
@@ -118,9 +161,7 @@ int MppEncoder::init(int width, int height, int fps){
         return true;
     };
 
-    printf("[MPP] using minimal encoder config for compatibility test\n");
-    fflush(stdout);
-    if (!set_s32("codec:type", MPP_VIDEO_CodingAVC) ||
+    if (!set_s32("codec:type", coding) ||
         !set_s32("prep:width", width) ||
         !set_s32("prep:height", height) ||
         !set_s32("prep:hor_stride", hor_stride) ||
@@ -130,6 +171,12 @@ int MppEncoder::init(int width, int height, int fps){
         return -1;
     }
 
+    // 码率控制、GOP、QP 和 profile/level
+    if (apply_config(cfg, config) < 0) {
+        mpp_enc_cfg_deinit(cfg);
+        return -1;
+    }
+
     // 应用配置
 #ifdef MPP_ENC_SET_EXT_BUF_GROUP
     printf("[MPP] create internal buffer group...\n");
@@ -169,6 +216,13 @@ int MppEncoder::init(int width, int height, int fps){
     printf("[MPP] MPP_ENC_SET_CFG ok\n");
     fflush(stdout);
 
+    // 每个 IDR/IRAP 前都输出参数集 (H.265 为 VPS/SPS/PPS)，中途加入的客户端和分辨率切换后都能直接解码
+    MppEncHeaderMode header_mode = MPP_ENC_HEADER_MODE_EACH_IDR;
+    ret = mpi->control(ctx, MPP_ENC_SET_HEADER_MODE, &header_mode);
+    if (ret != MPP_OK) {
+        fprintf(stderr, "mpp control MPP_ENC_SET_HEADER_MODE failed, ret=%d, parameter sets only in the first frame\n", ret);
+    }
+
     // Some Rockchip MPP 1.5.x builds crash inside MPP_ENC_GET_EXTRA_INFO.
     // It is only used to cache SPS/PPS for prepending to IDR frames, so keep it
     // disabled on this platform and let the encoder output packets directly.
@@ -178,127 +232,599 @@ int MppEncoder::init(int width, int height, int fps){
 
     // 配置应用后释放cfg占据的系统内存
     mpp_enc_cfg_deinit(cfg);
+    enc_cfg = config;
+    slice_out = config.slice_output && config.split_mode != MPP_ENC_SPLIT_NONE;
 
     printf("MPP encoder initialized successfully\n");
     return 0;
 }
 
+/**
+ * @brief   把编码参数写入 MppEncCfg (不包括 prep 和 codec 类型)
+ * @param   cfg     MPP 编码配置
+ * @param   config  编码参数
+ * @return  0 成功，-1 失败
+ * @remark  codec 类型只在 init 时设置，reconfigure 忽略 config.coding；FIXQP 模式下 QP 上下限都设为 qp_init；帧率输入输出相同，不做帧率转换；
+ *          条带输出只在设置了条带划分时生效
+**/
+int MppEncoder::apply_config(MppEncCfg cfg, const MppEncoderConfig &config){
+    auto set_s32 = [&](const char *name, int value) -> bool {
+        MPP_RET ret = mpp_enc_cfg_set_s32(cfg, name, value);
+        if (ret != MPP_OK) {
+            fprintf(stderr, "mpp_enc_cfg_set_s32(%s=%d) failed, ret=%d\n", name, value, ret);
+            return false;
+        }
+        return true;
+    };
+
+    const bool fixqp = config.rc_mode == MPP_ENC_RC_MODE_FIXQP;
+    const int qp_min = fixqp ? config.qp_init : config.qp_min;
+    const int qp_max = fixqp ? config.qp_init : config.qp_max;
+    const int qp_min_i = fixqp ? config.qp_init : config.qp_min_i;
+    const int qp_max_i = fixqp ? config.qp_init : config.qp_max_i;
+
+    if (!set_s32("rc:mode", config.rc_mode) ||
+        !set_s32("rc:fps_in_flex", 0) ||
+        !set_s32("rc:fps_in_num", config.fps) ||
+        !set_s32("rc:fps_in_denom", 1) ||
+        !set_s32("rc:fps_out_flex", 0) ||
+        !set_s32("rc:fps_out_num", config.fps) ||
+        !set_s32("rc:fps_out_denom", 1) ||
+        !set_s32("rc:gop", config.gop) ||
+        !set_s32("rc:bps_target", config.bps_target) ||
+        !set_s32("rc:bps_min", config.bps_min) ||
+        !set_s32("rc:bps_max", config.bps_max) ||
+        !set_s32("rc:qp_init", config.qp_init) ||
+        !set_s32("rc:qp_min", qp_min) ||
+        !set_s32("rc:qp_max", qp_max) ||
+        !set_s32("rc:qp_min_i", qp_min_i) ||
+        !set_s32("rc:qp_max_i", qp_max_i)) {
+        return -1;
+    }
+
+    // profile/level 只对 H.264 设置，H.265 使用编码器默认的 Main profile 和自动选择的 level
+    if (!is_hevc() &&
+        (!set_s32("h264:profile", config.profile) ||
+         !set_s32("h264:level", config.level) ||
+         // Baseline 不支持 CABAC 和 8x8 变换
+         !set_s32("h264:cabac_en", config.profile >= 77 ? 1 : 0) ||
+         !set_s32("h264:cabac_idc", 0) ||
+         !set_s32("h264:trans8x8", config.profile >= 100 ? 1 : 0))) {
+        return -1;
+    }
+
+    // 条带划分和条带输出 (低时延模式下编码器每完成一个条带就输出一个包，最后一个包带 EOI 标记)
+    const bool split = config.split_mode != MPP_ENC_SPLIT_NONE;
+    if (!set_s32("split:mode", config.split_mode) ||
+        !set_s32("split:arg", split ? config.split_arg : 0) ||
+        !set_s32("split:out", (split && config.slice_output) ? MPP_ENC_SPLIT_OUT_LOWDELAY : 0)) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief   运行中修改编码参数
+ * @param   config  新的编码参数
+ * @return  0 成功，-1 失败 (失败时保持原来的参数)
+ * @remark  读出当前配置、改写码率控制相关字段后重新 MPP_ENC_SET_CFG，不重建编码上下文，不打断码流；
+ *          异步模式下也可以在提交线程中调用，新参数从编码器处理的下一帧开始生效。
+**/
+int MppEncoder::reconfigure(const MppEncoderConfig &config){
+    if (!ctx) return -1;
+
+    MppEncCfg cfg = NULL;
+    MPP_RET ret = mpp_enc_cfg_init(&cfg);
+    if (ret != MPP_OK || !cfg) {
+        fprintf(stderr, "mpp_enc_cfg_init failed, ret=%d\n", ret);
+        return -1;
+    }
+    ret = mpi->control(ctx, MPP_ENC_GET_CFG, cfg);
+    if (ret != MPP_OK) {
+        fprintf(stderr, "mpp control MPP_ENC_GET_CFG failed, ret=%d\n", ret);
+        mpp_enc_cfg_deinit(cfg);
+        return -1;
+    }
+    if (apply_config(cfg, config) < 0) {
+        mpp_enc_cfg_deinit(cfg);
+        return -1;
+    }
+    ret = mpi->control(ctx, MPP_ENC_SET_CFG, cfg);
+    mpp_enc_cfg_deinit(cfg);
+    if (ret != MPP_OK) {
+        fprintf(stderr, "mpp control MPP_ENC_SET_CFG failed, ret=%d\n", ret);
+        return -1;
+    }
+
+    enc_cfg = config;
+    enc_cfg.coding = coding;
+    slice_out = config.slice_output && config.split_mode != MPP_ENC_SPLIT_NONE;
+    return 0;
+}
+
+/**
+ * @brief   运行中修改编码分辨率
+ * @param   width   新的宽度
+ * @param   height  新的高度
+ * @return  0 成功，-1 失败
+ * @remark  通过 MPP_ENC_SET_CFG 修改 prep 尺寸，编码器随后输出新的 SPS/PPS 和 IDR，不重建编码上下文。
+ *          已导入的输入缓冲区保留，只更新对应 MppFrame 的宽高，缓冲区需要不小于新尺寸的一帧 NV12。
+**/
+int MppEncoder::resize(int width, int height){
+    if (!ctx) return -1;
+    if (width == this->width && height == this->height) return 0;
+
+    if (async_running) {
+        // 编码器中还有旧尺寸的帧，它们共用缓存的 MppFrame，等全部输出后再改
+        std::unique_lock<std::mutex> lock(async_mtx);
+        async_cv.wait(lock, [this]{ return in_flight.empty(); });
+    }
+
+    MppEncCfg cfg = NULL;
+    MPP_RET ret = mpp_enc_cfg_init(&cfg);
+    if (ret != MPP_OK || !cfg) {
+        fprintf(stderr, "mpp_enc_cfg_init failed, ret=%d\n", ret);
+        return -1;
+    }
+    ret = mpi->control(ctx, MPP_ENC_GET_CFG, cfg);
+    if (ret == MPP_OK) {
+        mpp_enc_cfg_set_s32(cfg, "prep:width", width);
+        mpp_enc_cfg_set_s32(cfg, "prep:height", height);
+        mpp_enc_cfg_set_s32(cfg, "prep:hor_stride", align_up(width, 16));
+        mpp_enc_cfg_set_s32(cfg, "prep:ver_stride", align_up(height, 16));
+        ret = mpi->control(ctx, MPP_ENC_SET_CFG, cfg);
+    }
+    mpp_enc_cfg_deinit(cfg);
+    if (ret != MPP_OK) {
+        fprintf(stderr, "mpp control MPP_ENC_SET_CFG (resize %dx%d) failed, ret=%d\n", width, height, ret);
+        return -1;
+    }
+
+    this->width = width;
+    this->height = height;
+    for (auto &slot : inputs) {
+        mpp_frame_set_width(slot.frame, width);
+        mpp_frame_set_height(slot.frame, height);
+        mpp_frame_set_hor_stride(slot.frame, width);
+        mpp_frame_set_ver_stride(slot.frame, height);
+    }
+    printf("[MPP] encoder resized to %dx%d\n", width, height);
+    return 0;
+}
+
+int MppEncoder::request_idr(){
+    if (!ctx) return -1;
+    MPP_RET ret = mpi->control(ctx, MPP_ENC_SET_IDR_FRAME, NULL);
+    if (ret != MPP_OK) {
+        fprintf(stderr, "mpp control MPP_ENC_SET_IDR_FRAME failed, ret=%d\n", ret);
+        return -1;
+    }
+    return 0;
+}
+
 /** 
  * @brief   编码一帧数据
  * @param   dma_fd   输入帧的 DMA FD (RGA转换好的 NV12 数据的 FD)
- * @param   out_data 输出参数，编码后的 H264 码流指针
- * @param   out_len  输出参数，编码后的码流长度
+ * @param   out      输出参数，编码后的 H.264/H.265 访问单元 (引用 MPP 包内存的片段)
  * @return  0 成功，-1 失败
- * @remark  每调用一次 encode 就会编码一帧数据，编码后的数据通过 out_data 和 out_len 返回
- *          调用者需要负责释放 out_data 指向的内存。      
+ * @remark  每调用一次 encode 就会编码一帧数据。输出的片段直接引用 MppPacket 的内存，不做拼接拷贝；
+ *          所有引用释放后包才归还给 MPP，调用者 (及其下游) 持有片段期间编码器会使用新的输出缓冲区。
  */
-int MppEncoder::encode(int dma_fd, void **out_data, size_t *out_len){
-    if (!out_data || !out_len) return -1;
-    *out_data = NULL;
-    *out_len = 0;
+int MppEncoder::encode(int dma_fd, EncodedFrame &out){
+    out.clear();
+    if (async_running) return -1; // 异步模式下使用 submit
 
     MPP_RET ret = MPP_OK;
 
-    // 创建一个 MppFrame 用于存放输入帧数据
-    MppFrame frame = NULL;
-    mpp_frame_init(&frame);
-    mpp_frame_set_width(frame, width);
-    mpp_frame_set_height(frame, height);
-    mpp_frame_set_hor_stride(frame, width);
-    mpp_frame_set_ver_stride(frame, height);
-    mpp_frame_set_fmt(frame, MPP_FMT_YUV420SP);
+    // 取出该 fd 对应的已导入缓冲区和 MppFrame，只有第一次遇到时才 import
+    InputSlot *slot = find_input(dma_fd, width * height * 3 / 2); // NV12 大小
+    if (!slot) {
+        return -1;
+    }
+    attach_roi(slot->frame, roi_regions, roi_cfg);
 
-    // 设置FD 让MPP去读取数据
-    MppBuffer buffer = NULL;
-    MppBufferInfo buffer_info;
-    memset(&buffer_info, 0, sizeof(buffer_info));
-    buffer_info.type = MPP_BUFFER_TYPE_EXT_DMA;
-    buffer_info.size = width * height * 3 / 2; // NV12 大小
-    buffer_info.fd = dma_fd;
-    buffer_info.index = 0; // 可选，表示第几个平面，NV12只有一个平面
+    // 送入编码器 (同步模式下取完包时编码器已经读完这一帧，MppFrame 可以直接复用)
+    ret = mpi->encode_put_frame(ctx, slot->frame);
 
-    // 将外部DMA内存导入MPP，得到一个MPP可用的Buffer对象
-    ret = mpp_buffer_import(&buffer, &buffer_info);
     if (ret != MPP_OK) {
-        fprintf(stderr, "mpp_buffer_import failed\n");
-        mpp_frame_deinit(&frame);
+        fprintf(stderr, "encode_put_frame failed\n");
         return -1;
     }
-    // 将import的buffer内存句柄关联到设置好相关格式的frame上，供编码器读取
-    mpp_frame_set_buffer(frame, buffer);
 
-    // 送入编码器
-    ret = mpi->encode_put_frame(ctx, frame);
+    // 循环取包，每个包作为一个片段挂到输出上 (条带输出时取到带 EOI 标记的包为止)
+    while (1) {
+        MppPacket pkt = NULL;
+        ret = mpi->encode_get_packet(ctx, &pkt);
+        if (ret != MPP_OK || pkt == NULL) break;
 
-    if(buffer){
-        mpp_buffer_put(buffer);
+        bool end = is_frame_end(pkt);
+        append_packet(out, pkt, pending_sei);
+        if (end && slice_output()) break;
     }
+    
+    // 本帧没有找到条带时丢弃 SEI，避免错配到下一帧
+    pending_sei.clear();
 
-    // 防止内存泄漏，及时释放frame占用的系统内存
-    mpp_frame_deinit(&frame);
+    return 0;
 
+}
+
+/**
+ * @brief   编码一帧数据，逐条带交付
+ * @param   dma_fd    输入帧的 DMA FD
+ * @param   on_slice  每取得一个包就调用一次，参数中 last 为 true 的是这一帧的最后一部分
+ * @return  0 成功，-1 失败
+ * @remark  条带输出时 VPU 编码后续条带的同时，调用者就可以发送已经完成的条带，接收端也可以提前开始解码；
+ *          未开启条带输出时每个包就是完整的一帧，与 encode(dma_fd, out) 相同。回调返回后片段引用即被释放。
+**/
+int MppEncoder::encode(int dma_fd, const SliceCallback &on_slice){
+    if (async_running) return -1; // 异步模式下使用 submit
+
+    InputSlot *slot = find_input(dma_fd, width * height * 3 / 2); // NV12 大小
+    if (!slot) {
+        return -1;
+    }
+    attach_roi(slot->frame, roi_regions, roi_cfg);
+
+    MPP_RET ret = mpi->encode_put_frame(ctx, slot->frame);
     if (ret != MPP_OK) {
         fprintf(stderr, "encode_put_frame failed\n");
         return -1;
     }
 
-    // [修复] 循环取包并拼接
-    size_t total = 0;
-
+    EncodedFrame part;
     while (1) {
         MppPacket pkt = NULL;
         ret = mpi->encode_get_packet(ctx, &pkt);
         if (ret != MPP_OK || pkt == NULL) break;
 
-        // 获取包数据和长度
-        size_t len = mpp_packet_get_length(pkt);
-        unsigned char *ptr = (unsigned char *)mpp_packet_get_pos(pkt);
-        uint32_t flag = mpp_packet_get_flag(pkt);
-
-        bool is_idr = false;
-        if (ptr && len > 4) {
-            // 扫描前 256 个字节寻找 IDR 帧。因为 SPS/PPS/SEI 加起来通常只有几十个字节
-            size_t search_max = (len > 256) ? 256 : len;
-            for (size_t i = 0; i < search_max - 3; i++) {
-                // 只要找到 00 00 01 起始码，就能兼容 3字节 和 4字节 起始码的情况
-                // H.264 国际标准 Annex B 规定 NALU 以 00 00 01 或 00 00 00 01 起始
-                if (ptr[i] == 0x00 && ptr[i+1] == 0x00 && ptr[i+2] == 0x01) {
-                    int nalu_type = ptr[i+3] & 0x1F; // NALU 类型: 低5位
-                    if (nalu_type == 5) { // 找到 IDR 帧
-                        is_idr = true;
-                        break; 
-                    }
+        bool end = is_frame_end(pkt);
+        append_packet(part, pkt, pending_sei);
+        part.last = end;
+        if ((part.size > 0 || end) && on_slice) {
+            on_slice(part);
+        }
+        part.clear();
+        if (end && slice_output()) break;
+    }
+
+    pending_sei.clear();
+    return 0;
+}
+
+// 包是否为一帧的最后一个包 (条带输出时 MPP 在最后一个条带的包上设置 EOI 标记)
+bool MppEncoder::is_frame_end(MppPacket pkt) const {
+    return !slice_output() || mpp_packet_is_eoi(pkt);
+}
+
+/**
+ * @brief   把一个 MppPacket 作为片段挂到输出的访问单元上
+ * @param   out  输出的访问单元
+ * @param   pkt  编码器输出的包，所有权转移给片段 (引用全部释放后 mpp_packet_deinit)
+ * @param   sei  要插在第一个图像条带之前的 SEI，插入后清空
+**/
+void MppEncoder::append_packet(EncodedFrame &out, MppPacket pkt, std::vector<unsigned char> &sei){
+    // 获取包数据和长度
+    size_t len = mpp_packet_get_length(pkt);
+    unsigned char *ptr = (unsigned char *)mpp_packet_get_pos(pkt);
+    if (!ptr || len == 0) {
+        mpp_packet_deinit(&pkt);
+        return;
+    }
+
+    const bool hevc = is_hevc();
+    bool is_idr = false;
+    if (len > 4) {
+        // 扫描前 256 个字节寻找 IDR/IRAP 帧。因为参数集和 SEI 加起来通常只有几十个字节
+        size_t search_max = (len > 256) ? 256 : len;
+        for (size_t i = 0; i < search_max - 3; i++) {
+            // 只要找到 00 00 01 起始码，就能兼容 3字节 和 4字节 起始码的情况
+            // H.264 / H.265 Annex B 规定 NALU 以 00 00 01 或 00 00 00 01 起始
+            if (ptr[i] == 0x00 && ptr[i+1] == 0x00 && ptr[i+2] == 0x01) {
+                if (is_irap_nal(nal_type(ptr + i + 3, hevc), hevc)) { // 找到 IDR/IRAP 帧
+                    is_idr = true;
+                    break; 
                 }
             }
-            // 调试可以打开这个日志，看看每个包的类型和长度
-            // printf("Got packet: len=%zu, is_idr=%d\n", len, is_idr);
         }
+        // 调试可以打开这个日志，看看每个包的类型和长度
+        // printf("Got packet: len=%zu, is_idr=%d\n", len, is_idr);
+    }
+
+    // 包的引用计数归零时才向MPP反馈释放包内存
+    std::shared_ptr<uint8_t> hold(ptr, [pkt](uint8_t *) mutable { mpp_packet_deinit(&pkt); });
 
-        // 如果是IDR帧，优先拼接SPS/PPS
-        if (is_idr && total == 0 && !codec_header.empty()){
-            if (total + codec_header.size() < packet_buf_size) {
-                memcpy(packet_buf, codec_header.data(), codec_header.size());
-                total += codec_header.size();
+    // 如果是IDR帧，优先拼接参数集
+    if (is_idr && out.spans.empty() && !codec_header.empty()) {
+        auto header = std::make_shared<std::vector<unsigned char> >(codec_header);
+        add_span(out, std::shared_ptr<uint8_t>(header, header->data()), header->size());
+    }
+    out.is_idr = out.is_idr || is_idr;
+
+    // SEI 插在第一个图像条带之前，与该帧的参数集和条带属于同一个访问单元
+    if (!sei.empty()) {
+        long slice = find_first_slice(ptr, len, hevc);
+        if (slice >= 0) {
+            if (slice > 0) {
+                add_span(out, hold, slice);
             }
+            auto nal = std::make_shared<std::vector<unsigned char> >();
+            nal->swap(sei);
+            add_span(out, std::shared_ptr<uint8_t>(nal, nal->data()), nal->size());
+            add_span(out, std::shared_ptr<uint8_t>(hold, ptr + slice), len - slice);
+            return;
         }
+    }
 
-        // 安全检查：防止内存越界，确保有足够空间存放新数据
-        if (total + len <= packet_buf_size) {
-            memcpy(packet_buf + total, ptr, len);
-            total += len;
-        }
+    add_span(out, hold, len);
+}
 
-        // 向MPP反馈释放包内存
-        mpp_packet_deinit(&pkt);
+/**
+ * @brief   启动异步编码模式
+ * @param   queue_depth  最多同时在编码器中的帧数 (>= 1)
+ * @param   callback     码流回调，在输出线程中按提交顺序调用
+ * @return  0 成功，-1 失败
+ * @remark  提交 (submit) 在调用者线程，取包在独立的输出线程，VPU 编码与下一帧的预处理、推理并行。
+ *          回调返回后片段的引用即被释放，需要保留码流的回调应自行复制 EncodedFrame (只复制引用)。
+**/
+int MppEncoder::start_async(int queue_depth, PacketCallback callback){
+    if (!ctx || async_running || queue_depth < 1) return -1;
+
+    // 取包超时后检查是否需要退出
+    MppPollType timeout = (MppPollType)100;
+    MPP_RET ret = mpi->control(ctx, MPP_SET_OUTPUT_TIMEOUT, &timeout);
+    if (ret != MPP_OK) {
+        fprintf(stderr, "mpp control MPP_SET_OUTPUT_TIMEOUT failed, ret=%d\n", ret);
+        return -1;
     }
-    
-    if(total > 0){
-        *out_data = packet_buf;
-        *out_len = total;
+
+    this->queue_depth = queue_depth;
+    this->callback = callback;
+    async_running = true;
+    output_thread = std::thread(&MppEncoder::output_loop, this);
+    printf("[MPP] async encoder started, queue depth %d\n", queue_depth);
+    return 0;
+}
+
+/**
+ * @brief   异步提交一帧
+ * @param   dma_fd  输入帧的 DMA FD
+ * @return  0 成功，-1 失败
+**/
+int MppEncoder::submit(int dma_fd){
+    if (!async_running) return -1;
+
+    InputSlot *slot = find_input(dma_fd, width * height * 3 / 2); // NV12 大小
+    if (!slot) {
+        return -1;
     }
 
+    {
+        // 编码器中的帧数达到队列深度时等待输出线程取走一帧
+        std::unique_lock<std::mutex> lock(async_mtx);
+        async_cv.wait(lock, [this]{ return (int)in_flight.size() < queue_depth; });
+        PendingFrame pending;
+        pending.sei.swap(pending_sei);
+        pending.submit_us = now_us();
+        in_flight.push_back(std::move(pending));
+        // ROI 保存在队列中的这一项里，frame meta 指向它，直到这一帧的码流取出
+        PendingFrame &queued = in_flight.back();
+        attach_roi(slot->frame, queued.roi, queued.roi_cfg);
+    }
+
+    MPP_RET ret = mpi->encode_put_frame(ctx, slot->frame);
+    if (ret != MPP_OK) {
+        fprintf(stderr, "encode_put_frame failed\n");
+        // 这一帧不会有码流输出，撤销记录 (只有本线程提交，队尾就是这一帧)
+        std::lock_guard<std::mutex> lock(async_mtx);
+        in_flight.pop_back();
+        async_cv.notify_all();
+        return -1;
+    }
     return 0;
+}
 
+/**
+ * @brief   输出线程：取包、插入 SEI、回调
+ * @remark  条带输出时一帧有多个包，每个包回调一次，最后一个包 (EOI) 回调后该帧才出队
+**/
+void MppEncoder::output_loop(){
+    EncodedFrame frame;
+    while (1) {
+        MppPacket pkt = NULL;
+        MPP_RET ret = mpi->encode_get_packet(ctx, &pkt);
+        if (ret != MPP_OK || pkt == NULL) {
+            // 超时：停止时没有待输出的帧 (或编码器不再输出) 就退出
+            std::lock_guard<std::mutex> lock(async_mtx);
+            if (!async_running) break;
+            continue;
+        }
+
+        const bool end = is_frame_end(pkt);
+        PendingFrame *pending = NULL;
+        {
+            std::lock_guard<std::mutex> lock(async_mtx);
+            if (in_flight.empty()) {
+                // 不属于任何已提交帧的包，丢弃
+                mpp_packet_deinit(&pkt);
+                continue;
+            }
+            // 队首只由本线程出队，submit 只在队尾追加 (deque 追加不会使元素的引用失效)
+            pending = &in_flight.front();
+        }
+
+        // SEI 插在这一帧第一个条带之前，之后的包不再插入
+        append_packet(frame, pkt, pending->sei);
+        frame.last = end;
+        const int64_t latency_us = now_us() - pending->submit_us;
+        if (end) {
+            std::lock_guard<std::mutex> lock(async_mtx);
+            in_flight.pop_front();
+            async_cv.notify_all();
+        }
+
+        if (callback) {
+            callback(frame, latency_us);
+        }
+        frame.clear();
+
+        std::lock_guard<std::mutex> lock(async_mtx);
+        if (!async_running && in_flight.empty()) break;
+    }
+}
+
+void MppEncoder::stop_async(){
+    if (!async_running) return;
+    {
+        std::lock_guard<std::mutex> lock(async_mtx);
+        async_running = false;
+    }
+    if (output_thread.joinable()) {
+        output_thread.join();
+    }
+    in_flight.clear();
+    callback = nullptr;
+}
+
+/**
+ * @brief   预先导入一块输入 DMA 缓冲区
+ * @param   dma_fd  DMA 缓冲区 FD
+ * @param   size    缓冲区大小 (字节)，不能小于一帧 NV12 的大小
+ * @return  0 成功，-1 失败
+ * @remark  多缓冲的流水线可以在启动时把所有缓冲区导入一遍，编码时不再有任何 import 和内存分配
+**/
+int MppEncoder::import_buffer(int dma_fd, size_t size){
+    return find_input(dma_fd, size) ? 0 : -1;
+}
+
+/**
+ * @brief   查找或导入 fd 对应的输入缓冲区
+ * @param   dma_fd  DMA 缓冲区 FD
+ * @param   size    需要的大小 (字节)
+ * @return  缓存项指针，失败返回 NULL
+ * @remark  缓存项持有导入的 MppBuffer 和一个绑定了该缓冲区、格式已设置好的 MppFrame，直到 release_buffer 或 deinit
+**/
+MppEncoder::InputSlot* MppEncoder::find_input(int dma_fd, size_t size){
+    for (auto &slot : inputs) {
+        if (slot.fd == dma_fd && slot.size >= size) {
+            return &slot;
+        }
+    }
+    // 同一个 fd 但大小不够，说明 fd 号已经被其它缓冲区复用
+    release_buffer(dma_fd);
+
+    InputSlot slot;
+    slot.fd = dma_fd;
+    slot.size = size;
+    slot.buffer = NULL;
+    slot.frame = NULL;
+
+    // 设置FD 让MPP去读取数据
+    MppBufferInfo buffer_info;
+    memset(&buffer_info, 0, sizeof(buffer_info));
+    buffer_info.type = MPP_BUFFER_TYPE_EXT_DMA;
+    buffer_info.size = size;
+    buffer_info.fd = dma_fd;
+    buffer_info.index = 0; // 可选，表示第几个平面，NV12只有一个平面
+
+    // 将外部DMA内存导入MPP，得到一个MPP可用的Buffer对象
+    if (mpp_buffer_import(&slot.buffer, &buffer_info) != MPP_OK) {
+        fprintf(stderr, "mpp_buffer_import failed, fd=%d\n", dma_fd);
+        return NULL;
+    }
+
+    // 创建一个 MppFrame 用于存放输入帧数据
+    mpp_frame_init(&slot.frame);
+    mpp_frame_set_width(slot.frame, width);
+    mpp_frame_set_height(slot.frame, height);
+    mpp_frame_set_hor_stride(slot.frame, width);
+    mpp_frame_set_ver_stride(slot.frame, height);
+    mpp_frame_set_fmt(slot.frame, MPP_FMT_YUV420SP);
+    // 将import的buffer内存句柄关联到设置好相关格式的frame上，供编码器读取
+    mpp_frame_set_buffer(slot.frame, slot.buffer);
+
+    inputs.push_back(slot);
+    return &inputs.back();
+}
+
+void MppEncoder::release_buffer(int dma_fd){
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (inputs[i].fd != dma_fd) continue;
+        mpp_frame_deinit(&inputs[i].frame);
+        mpp_buffer_put(inputs[i].buffer);
+        inputs.erase(inputs.begin() + i);
+        return;
+    }
+}
+
+/**
+ * @brief   把待提交的 ROI 转成 MPP 区域并挂到输入帧的 meta 上 (KEY_ROI_DATA)
+ * @param   frame    输入帧 (按 fd 缓存复用的 MppFrame)
+ * @param   regions  MPP 区域的存放位置，编码器读取之前不能释放
+ * @param   cfg      ROI 配置的存放位置，同上
+ * @remark  第 0 个区域为整帧背景 (roi_bg_qp_delta)，之后为各目标 (roi_qp_delta)，后面的区域覆盖前面的；
+ *          区域按 16 像素 (宏块) 对齐。QP 偏移是相对码率控制给出的 QP，总码率仍由码率控制约束。
+ *          缓存复用的 MppFrame 会保留上一次设置的 meta，所以每帧都重新设置，没有 ROI 时设置为空配置。
+**/
+void MppEncoder::attach_roi(MppFrame frame, std::vector<MppEncROIRegion> &regions, MppEncROICfg &cfg){
+    regions.clear();
+    if (!pending_roi.empty()) {
+        std::vector<RoiBox> boxes;
+        boxes.swap(pending_roi);
+        // 目标太多时保留面积最大的
+        const size_t max_boxes = ENC_MAX_ROI_REGIONS - 1;
+        if (boxes.size() > max_boxes) {
+            std::partial_sort(boxes.begin(), boxes.begin() + max_boxes, boxes.end(),
+                [](const RoiBox &a, const RoiBox &b) {
+                    return (a.right - a.left) * (a.bottom - a.top) > (b.right - b.left) * (b.bottom - b.top);
+                });
+            boxes.resize(max_boxes);
+        }
+
+        auto add_region = [&](int left, int top, int right, int bottom, int qp_delta) {
+            // 按宏块对齐并限制在画面内
+            left = std::max(left, 0) & ~15;
+            top = std::max(top, 0) & ~15;
+            right = std::min(align_up(right, 16), align_up(width, 16));
+            bottom = std::min(align_up(bottom, 16), align_up(height, 16));
+            if (right <= left || bottom <= top) return;
+
+            MppEncROIRegion region;
+            memset(&region, 0, sizeof(region));
+            region.x = left;
+            region.y = top;
+            region.w = right - left;
+            region.h = bottom - top;
+            region.intra = 0;
+            region.quality = qp_delta;  // abs_qp_en = 0 时为相对 QP
+            region.qp_area_idx = regions.size();
+            region.area_map_en = 1;
+            region.abs_qp_en = 0;
+            regions.push_back(region);
+        };
+
+        add_region(0, 0, width, height, enc_cfg.roi_bg_qp_delta);
+        const int margin = enc_cfg.roi_margin;
+        for (const auto &box : boxes) {
+            add_region(box.left - margin, box.top - margin, box.right + margin, box.bottom + margin, enc_cfg.roi_qp_delta);
+        }
+        // 没有有效的目标区域时不单独调整背景
+        if (regions.size() == 1) {
+            regions.clear();
+        }
+    }
+
+    cfg.number = regions.size();
+    cfg.regions = regions.empty() ? NULL : regions.data();
+    mpp_meta_set_ptr(mpp_frame_get_meta(frame), KEY_ROI_DATA, &cfg);
+}
+
+void MppEncoder::add_span(EncodedFrame &out, std::shared_ptr<uint8_t> data, size_t len){
+    EncodedSpan span;
+    span.data = data;
+    span.len = len;
+    out.spans.push_back(span);
+    out.size += len;
 }
 
 
@@ -307,16 +833,15 @@ int MppEncoder::encode(int dma_fd, void **out_data, size_t *out_len){
                 调用者在不需要编码时应该调用这个函数来清理资源。
 */
 void MppEncoder::deinit(){
+    stop_async();
+    while(!inputs.empty()){
+        release_buffer(inputs.back().fd);
+    }
     if(ctx){
         mpp_destroy(ctx);
         ctx = NULL;
         mpi = NULL;
     }
-    if(packet_buf){
-        free(packet_buf);
-        packet_buf = NULL;
-        packet_buf_size = 0;
-    }
     if(buf_grp){
         mpp_buffer_group_put(buf_grp);
         buf_grp = NULL;
@@ -0,0 +1,146 @@
+#include "npu_scheduler.h"
+#include "count_utils.h"
+#include <stdio.h>
+#include <algorithm>
+
+NpuScheduler::NpuScheduler() : next_seq(0), running(false) {
+}
+
+NpuScheduler::~NpuScheduler(){
+    stop();
+}
+
+int NpuScheduler::register_model(const std::string& name, int priority, int deadline_ms){
+    ModelSlot slot;
+    slot.name = name;
+    slot.priority = priority;
+    slot.deadline_us = (int64_t)deadline_ms * 1000;
+    slot.runs = 0;
+    slot.expired = 0;
+    slot.wait_us = 0;
+    slot.wait_max_us = 0;
+    slot.run_us = 0;
+    std::lock_guard<std::mutex> lk(mtx);
+    models.push_back(slot);
+    return (int)models.size() - 1;
+}
+
+void NpuScheduler::start(){
+    std::lock_guard<std::mutex> lk(mtx);
+    if(running) return;
+    running = true;
+    worker = std::thread(&NpuScheduler::loop, this);
+}
+
+/**
+ * @brief  停止调度线程，队列中尚未执行的任务返回 NPU_TASK_STOPPED
+**/
+void NpuScheduler::stop(){
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        if(!running) return;
+        running = false;
+    }
+    cv.notify_all();
+    if(worker.joinable()) worker.join();
+    for(auto& t : queue) t.result->set_value(NPU_TASK_STOPPED);
+    queue.clear();
+}
+
+/**
+ * @brief  提交一个推理任务
+ * @param  model 模型编号 (register_model 的返回值)
+ * @param  job   在调度线程上执行的推理函数，返回 0 成功
+ * @return 任务结果；被丢弃时为 NPU_TASK_EXPIRED / NPU_TASK_STOPPED
+**/
+std::future<int> NpuScheduler::submit(int model, std::function<int()> job){
+    Task t;
+    t.model = model;
+    t.submit_us = now_us();
+    t.job = job;
+    t.result = std::make_shared<std::promise<int> >();
+    std::future<int> fut = t.result->get_future();
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        if(!running){
+            t.result->set_value(NPU_TASK_STOPPED);
+            return fut;
+        }
+        t.deadline_us = models[model].deadline_us > 0 ? t.submit_us + models[model].deadline_us : 0;
+        t.seq = next_seq++;
+        queue.push_back(t);
+    }
+    cv.notify_one();
+    return fut;
+}
+
+// 选出下一个任务：优先级高的优先，其次截止时间早的 (不限截止时间的排在最后)，最后按提交顺序
+size_t NpuScheduler::pick_next() const {
+    size_t best = 0;
+    for(size_t i=1;i<queue.size();i++){
+        const Task& a = queue[i];
+        const Task& b = queue[best];
+        int pa = models[a.model].priority, pb = models[b.model].priority;
+        if(pa != pb){
+            if(pa > pb) best = i;
+            continue;
+        }
+        uint64_t da = a.deadline_us ? (uint64_t)a.deadline_us : UINT64_MAX;
+        uint64_t db = b.deadline_us ? (uint64_t)b.deadline_us : UINT64_MAX;
+        if(da != db){
+            if(da < db) best = i;
+            continue;
+        }
+        if(a.seq < b.seq) best = i;
+    }
+    return best;
+}
+
+void NpuScheduler::loop(){
+    std::unique_lock<std::mutex> lk(mtx);
+    while(running){
+        if(queue.empty()){
+            cv.wait(lk);
+            continue;
+        }
+        size_t idx = pick_next();
+        Task t = queue[idx];
+        queue.erase(queue.begin() + idx);
+
+        int64_t start = now_us();
+        ModelSlot& slot = models[t.model];
+        if(t.deadline_us && start > t.deadline_us){
+            slot.expired++;
+            lk.unlock();
+            t.result->set_value(NPU_TASK_EXPIRED);
+            lk.lock();
+            continue;
+        }
+
+        lk.unlock();
+        int ret = t.job();
+        int64_t end = now_us();
+        lk.lock();
+
+        int64_t wait = start - t.submit_us;
+        slot.runs++;
+        slot.wait_us += wait;
+        slot.wait_max_us = std::max(slot.wait_max_us, wait);
+        slot.run_us += end - start;
+        t.result->set_value(ret);
+    }
+}
+
+void NpuScheduler::report_stats(){
+    std::lock_guard<std::mutex> lk(mtx);
+    for(auto& s : models){
+        printf("[NPU] %-12s prio=%d runs=%4d expired=%3d avg wait=%6.2f ms max wait=%6.2f ms avg run=%6.2f ms\n",
+               s.name.c_str(), s.priority, s.runs, s.expired, s.runs ? s.wait_us / 1000.0 / s.runs : 0.0,
+               s.wait_max_us / 1000.0, s.runs ? s.run_us / 1000.0 / s.runs : 0.0);
+        s.runs = 0;
+        s.expired = 0;
+        s.wait_us = 0;
+        s.wait_max_us = 0;
+        s.run_us = 0;
+    }
+}
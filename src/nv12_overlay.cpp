@@ -0,0 +1,184 @@
+#include "nv12_overlay.h"
+#include <string.h>
+#include <algorithm>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define OVERLAY_NEON 1
+#else
+#define OVERLAY_NEON 0
+#endif
+
+#define FONT_FIRST  0x20
+#define FONT_LAST   0x7E
+#define FONT_COUNT  (FONT_LAST - FONT_FIRST + 1)
+
+// 5x7 点阵字体 (ASCII 0x20~0x7E)，每个字符 5 列，每列低位在上
+static const uint8_t font5x7[FONT_COUNT][5] = {
+    {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14},
+    {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00},
+    {0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, {0x08,0x2A,0x1C,0x2A,0x08}, {0x08,0x08,0x3E,0x08,0x08},
+    {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02},
+    {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31},
+    {0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03},
+    {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00},
+    {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06},
+    {0x32,0x49,0x79,0x41,0x3E}, {0x7E,0x11,0x11,0x11,0x7E}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22},
+    {0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x01,0x01}, {0x3E,0x41,0x41,0x51,0x32},
+    {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41},
+    {0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x04,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E},
+    {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31},
+    {0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, {0x1F,0x20,0x40,0x20,0x1F}, {0x7F,0x20,0x18,0x20,0x7F},
+    {0x63,0x14,0x08,0x14,0x63}, {0x03,0x04,0x78,0x04,0x03}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x00,0x7F,0x41,0x41},
+    {0x02,0x04,0x08,0x10,0x20}, {0x41,0x41,0x7F,0x00,0x00}, {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40},
+    {0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78}, {0x7F,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20},
+    {0x38,0x44,0x44,0x48,0x7F}, {0x38,0x54,0x54,0x54,0x18}, {0x08,0x7E,0x09,0x01,0x02}, {0x08,0x14,0x54,0x54,0x3C},
+    {0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, {0x20,0x40,0x44,0x3D,0x00}, {0x00,0x7F,0x10,0x28,0x44},
+    {0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x18,0x04,0x78}, {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38},
+    {0x7C,0x14,0x14,0x14,0x08}, {0x08,0x14,0x14,0x18,0x7C}, {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20},
+    {0x04,0x3F,0x44,0x40,0x20}, {0x3C,0x40,0x40,0x20,0x7C}, {0x1C,0x20,0x40,0x20,0x1C}, {0x3C,0x40,0x30,0x40,0x3C},
+    {0x44,0x28,0x10,0x28,0x44}, {0x0C,0x50,0x50,0x50,0x3C}, {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00},
+    {0x00,0x00,0x7F,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00}, {0x02,0x01,0x02,0x04,0x02},
+};
+
+OverlayColor overlay_color(uint8_t r, uint8_t g, uint8_t b){
+    OverlayColor c;
+    c.y = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+    c.u = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+    c.v = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    return c;
+}
+
+// 用交错的 (u, v) 填充 n 对 UV
+static void fill_uv_span(uint8_t* dst, int n, uint8_t u, uint8_t v){
+    int i = 0;
+#if OVERLAY_NEON
+    uint8x16_t pattern = vreinterpretq_u8_u16(vdupq_n_u16((uint16_t)(u | (v << 8))));
+    for(;i+8<=n;i+=8){
+        vst1q_u8(dst + i * 2, pattern);
+    }
+#endif
+    for(;i<n;i++){
+        dst[i * 2] = u;
+        dst[i * 2 + 1] = v;
+    }
+}
+
+Nv12Overlay::Nv12Overlay(const OverlayConfig& cfg)
+    : cfg(cfg), y_plane(nullptr), uv_plane(nullptr), width(0), height(0), stride(0) {
+    this->cfg.font_scale = std::max(1, cfg.font_scale);
+    this->cfg.box_thickness = std::max(2, (cfg.box_thickness + 1) & ~1);
+    cell_w = 6 * this->cfg.font_scale;
+    cell_h = 8 * this->cfg.font_scale;
+    build_atlas();
+}
+
+/**
+ * @brief  把 5x7 点阵按 font_scale 放大成字节掩码，每个字符右侧和下方各留一个点的间距
+**/
+void Nv12Overlay::build_atlas(){
+    const int s = cfg.font_scale;
+    atlas.assign((size_t)FONT_COUNT * cell_h * cell_w, 0);
+    for(int g=0;g<FONT_COUNT;g++){
+        uint8_t* glyph = atlas.data() + (size_t)g * cell_h * cell_w;
+        for(int col=0;col<5;col++){
+            for(int row=0;row<7;row++){
+                if(!(font5x7[g][col] & (1 << row))) continue;
+                for(int dy=0;dy<s;dy++){
+                    memset(glyph + (row * s + dy) * cell_w + col * s, 0xFF, s);
+                }
+            }
+        }
+    }
+}
+
+void Nv12Overlay::begin(uint8_t* nv12, int width, int height, int stride){
+    this->width = width;
+    this->height = height;
+    this->stride = stride > 0 ? stride : width;
+    y_plane = nv12;
+    uv_plane = nv12 + (size_t)this->stride * height;
+}
+
+/**
+ * @brief  填充矩形 [x0, x1) x [y0, y1)
+ * @remark 坐标按 2 对齐，保证亮度和色度 (2x2 共用一个 UV) 覆盖同一块区域
+**/
+void Nv12Overlay::fill_rect(int x0, int y0, int x1, int y1, OverlayColor color){
+    x0 = std::max(0, x0 & ~1);
+    y0 = std::max(0, y0 & ~1);
+    x1 = std::min(width & ~1, (x1 + 1) & ~1);
+    y1 = std::min(height & ~1, (y1 + 1) & ~1);
+    if(x0 >= x1 || y0 >= y1) return;
+
+    for(int y=y0;y<y1;y++){
+        memset(y_plane + (size_t)y * stride + x0, color.y, x1 - x0);
+    }
+    for(int y=y0/2;y<y1/2;y++){
+        fill_uv_span(uv_plane + (size_t)y * stride + x0, (x1 - x0) / 2, color.u, color.v);
+    }
+}
+
+/**
+ * @brief  绘制矩形框：拆成上下左右 4 个实心矩形，只写框线经过的行
+**/
+void Nv12Overlay::draw_box(int left, int top, int right, int bottom, OverlayColor color){
+    if(y_plane == nullptr) return;
+    const int t = cfg.box_thickness;
+    left = std::max(0, left);
+    top = std::max(0, top);
+    right = std::min(width, right);
+    bottom = std::min(height, bottom);
+    if(right - left <= 0 || bottom - top <= 0) return;
+
+    fill_rect(left, top, right, top + t, color);
+    fill_rect(left, bottom - t, right, bottom, color);
+    fill_rect(left, top + t, left + t, bottom - t, color);
+    fill_rect(right - t, top + t, right, bottom - t, color);
+}
+
+/**
+ * @brief  绘制一行带底色的文字
+ * @remark 每一行先在 row_buf 中按字形掩码选择前景/背景亮度，再整行拷贝到帧里；色度统一为底色
+**/
+void Nv12Overlay::draw_label(int x, int y, const char* text, OverlayColor fg, OverlayColor bg){
+    if(y_plane == nullptr || text == nullptr) return;
+    const int pad = cfg.font_scale;
+    x = std::max(0, x & ~1);
+    y = std::max(0, y & ~1);
+    int n = (int)strlen(text);
+    n = std::min(n, (width - x - 2 * pad) / cell_w);
+    if(n <= 0 || y >= height) return;
+
+    const int label_w = n * cell_w + 2 * pad;
+    const int label_h = std::min(label_height(), height - y);
+    fill_rect(x, y, x + label_w, y + label_h, bg);
+
+    row_mask.resize(label_w);
+    row_buf.resize(label_w);
+    const int glyph_rows = std::min(cell_h, label_h - pad);
+    for(int r=0;r<glyph_rows;r++){
+        memset(row_mask.data(), 0, pad);
+        for(int i=0;i<n;i++){
+            unsigned char ch = (unsigned char)text[i];
+            int g = (ch >= FONT_FIRST && ch <= FONT_LAST) ? ch - FONT_FIRST : '?' - FONT_FIRST;
+            memcpy(row_mask.data() + pad + i * cell_w, atlas.data() + ((size_t)g * cell_h + r) * cell_w, cell_w);
+        }
+        memset(row_mask.data() + pad + n * cell_w, 0, pad);
+
+        const uint8_t* m = row_mask.data();
+        uint8_t* out = row_buf.data();
+        int i = 0;
+#if OVERLAY_NEON
+        uint8x16_t vfg = vdupq_n_u8(fg.y);
+        uint8x16_t vbg = vdupq_n_u8(bg.y);
+        for(;i+16<=label_w;i+=16){
+            vst1q_u8(out + i, vbslq_u8(vld1q_u8(m + i), vfg, vbg));
+        }
+#endif
+        for(;i<label_w;i++){
+            out[i] = m[i] ? fg.y : bg.y;
+        }
+        memcpy(y_plane + (size_t)(y + pad + r) * stride + x, out, label_w);
+    }
+}
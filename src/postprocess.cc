@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include "postprocess.h"
+#include "yolo_decoder.h"
+#include "seg_mask.h"
 
 #include <math.h>
 #include <stdint.h>
@@ -21,11 +23,8 @@
 #include <string.h>
 #include <sys/time.h>
 
-#include <set>
+#include <algorithm>
 #include <vector>
-#define LABEL_NALE_TXT_PATH "../model/coco_80_labels_list.txt"
-
-static char *labels[OBJ_CLASS_NUM];
 
 const int anchor0[6] = {10, 13, 16, 30, 33, 23};
 const int anchor1[6] = {30, 61, 62, 45, 59, 119};
@@ -33,7 +32,7 @@ const int anchor2[6] = {116, 90, 156, 198, 373, 326};
 
 inline static int clamp(float val, int min, int max) { return val > min ? (val < max ? val : max) : min; }
 
-char *readLine(FILE *fp, char *buffer, int *len)
+static char *readLine(FILE *fp, char *buffer, int *len)
 {
   int ch;
   int i = 0;
@@ -70,36 +69,29 @@ char *readLine(FILE *fp, char *buffer, int *len)
   return buffer;
 }
 
-int readLines(const char *fileName, char *lines[], int max_line)
+static int loadLabelName(const char *locationFilename, std::vector<std::string> &labels, int class_num)
 {
-  FILE *file = fopen(fileName, "r");
-  char *s;
-  int i = 0;
-  int n = 0;
-
+  printf("loadLabelName %s\n", locationFilename);
+  FILE *file = fopen(locationFilename, "r");
   if (file == NULL)
   {
-    printf("Open %s fail!\n", fileName);
+    printf("Open %s fail!\n", locationFilename);
     return -1;
   }
 
-  while ((s = readLine(file, s, &n)) != NULL)
+  labels.assign(class_num, "unknown");
+  char *s;
+  int n = 0;
+  int i = 0;
+  while (i < class_num && (s = readLine(file, NULL, &n)) != NULL)
   {
-    lines[i++] = s;
-    if (i >= max_line)
-      break;
+    labels[i++] = s;
+    free(s);
   }
   fclose(file);
   return i;
 }
 
-int loadLabelName(const char *locationFilename, char *label[])
-{
-  printf("loadLabelName %s\n", locationFilename);
-  readLines(locationFilename, label, OBJ_CLASS_NUM);
-  return 0;
-}
-
 static float CalculateOverlap(float xmin0, float ymin0, float xmax0, float ymax0, float xmin1, float ymin1, float xmax1,
                               float ymax1)
 {
@@ -110,8 +102,8 @@ static float CalculateOverlap(float xmin0, float ymin0, float xmax0, float ymax0
   return u <= 0.f ? 0.f : (i / u);
 }
 
-static int nms(int validCount, std::vector<float> &outputLocations, std::vector<int> classIds, std::vector<int> &order,
-               int filterId, float threshold)
+static int nms(int validCount, const std::vector<float> &outputLocations, const std::vector<int> &classIds,
+               std::vector<int> &order, int filterId, float threshold)
 {
   for (int i = 0; i < validCount; ++i)
   {
@@ -200,117 +192,328 @@ static int8_t qnt_f32_to_affine(float f32, int32_t zp, float scale)
 
 static float deqnt_affine_to_f32(int8_t qnt, int32_t zp, float scale) { return ((float)qnt - (float)zp) * scale; }
 
-static int process(int8_t *input, int *anchor, int grid_h, int grid_w, int height, int width, int stride,
-                   std::vector<float> &boxes, std::vector<float> &objProbs, std::vector<int> &classId, float threshold,
-                   int32_t zp, float scale)
+void init_qnt_lut(qnt_lut_t *lut, int32_t zp, float scale, float conf_threshold)
 {
-  int validCount = 0;
-  int grid_len = grid_h * grid_w;
-  int8_t thres_i8 = qnt_f32_to_affine(threshold, zp, scale);
-  for (int a = 0; a < 3; a++)
+  lut->zp = zp;
+  lut->scale = scale;
+  lut->thres = conf_threshold;
+  lut->thres_i8 = qnt_f32_to_affine(conf_threshold, zp, scale);
+  for (int i = 0; i < 256; i++)
+  {
+    float f = deqnt_affine_to_f32((int8_t)i, zp, scale);
+    lut->deqnt[i] = f;
+    lut->box_xy[i] = f * 2.0 - 0.5;
+    lut->box_wh[i] = (f * 2.0) * (f * 2.0);
+    lut->dfl_exp[i] = expf(f);
+  }
+}
+
+static void get_output_chw(const rknn_tensor_attr *attr, int *c, int *h, int *w)
+{
+  if (attr->fmt == RKNN_TENSOR_NHWC)
+  {
+    *h = attr->dims[1];
+    *w = attr->dims[2];
+    *c = attr->dims[3];
+  }
+  else
   {
-    for (int i = 0; i < grid_h; i++)
+    *c = attr->dims[1];
+    *h = attr->dims[2];
+    *w = attr->dims[3];
+  }
+}
+
+/**
+ * 根据模型输出属性推断检测头类型、类别数和各分支的网格/步长
+ * 返回 0 成功，-1 表示不认识的输出布局
+ */
+int init_yolo_head(yolo_head_t *head, const rknn_tensor_attr *output_attrs, int n_output, int model_in_h,
+                   int model_in_w)
+{
+  memset(head, 0, sizeof(yolo_head_t));
+
+  int c, h, w;
+  if (n_output == YOLO_BRANCH_NUM * 2 + 1)
+  {
+    // YOLOv5-seg：box0, mask0, box1, mask1, box2, mask2, proto
+    int mc, mh, mw;
+    get_output_chw(&output_attrs[0], &c, &h, &w);
+    get_output_chw(&output_attrs[n_output - 1], &head->mask_dim, &head->proto_h, &head->proto_w);
+    get_output_chw(&output_attrs[1], &mc, &mh, &mw);
+    if (c % 3 != 0 || c / 3 <= 5 || mc != 3 * head->mask_dim || mh != h || mw != w)
     {
-      for (int j = 0; j < grid_w; j++)
-      {
-        int8_t box_confidence = input[(PROP_BOX_SIZE * a + 4) * grid_len + i * grid_w + j];
-        if (box_confidence >= thres_i8)
-        {
-          int offset = (PROP_BOX_SIZE * a) * grid_len + i * grid_w + j;
-          int8_t *in_ptr = input + offset;
-          float box_x = (deqnt_affine_to_f32(*in_ptr, zp, scale)) * 2.0 - 0.5;
-          float box_y = (deqnt_affine_to_f32(in_ptr[grid_len], zp, scale)) * 2.0 - 0.5;
-          float box_w = (deqnt_affine_to_f32(in_ptr[2 * grid_len], zp, scale)) * 2.0;
-          float box_h = (deqnt_affine_to_f32(in_ptr[3 * grid_len], zp, scale)) * 2.0;
-          box_x = (box_x + j) * (float)stride;
-          box_y = (box_y + i) * (float)stride;
-          box_w = box_w * box_w * (float)anchor[a * 2];
-          box_h = box_h * box_h * (float)anchor[a * 2 + 1];
-          box_x -= (box_w / 2.0);
-          box_y -= (box_h / 2.0);
-
-          int8_t maxClassProbs = in_ptr[5 * grid_len];
-          int maxClassId = 0;
-          for (int k = 1; k < OBJ_CLASS_NUM; ++k)
-          {
-            int8_t prob = in_ptr[(5 + k) * grid_len];
-            if (prob > maxClassProbs)
-            {
-              maxClassId = k;
-              maxClassProbs = prob;
-            }
-          }
-          if (maxClassProbs > thres_i8)
-          {
-            objProbs.push_back((deqnt_affine_to_f32(maxClassProbs, zp, scale)) * (deqnt_affine_to_f32(box_confidence, zp, scale)));
-            classId.push_back(maxClassId);
-            validCount++;
-            boxes.push_back(box_x);
-            boxes.push_back(box_y);
-            boxes.push_back(box_w);
-            boxes.push_back(box_h);
-          }
-        }
-      }
+      printf("unsupported yolov5-seg head: channel %d, mask channel %d, proto channel %d\n", c, mc, head->mask_dim);
+      return -1;
+    }
+    head->type = YOLO_HEAD_V5_SEG;
+    head->class_num = c / 3 - 5;
+    head->output_per_branch = 2;
+    memcpy(head->anchor[0], anchor0, sizeof(anchor0));
+    memcpy(head->anchor[1], anchor1, sizeof(anchor1));
+    memcpy(head->anchor[2], anchor2, sizeof(anchor2));
+  }
+  else if (n_output == YOLO_BRANCH_NUM)
+  {
+    get_output_chw(&output_attrs[0], &c, &h, &w);
+    if (c % 3 != 0 || c / 3 <= 5)
+    {
+      printf("unsupported yolov5 head: channel %d\n", c);
+      return -1;
+    }
+    head->type = YOLO_HEAD_V5;
+    head->class_num = c / 3 - 5;
+    head->output_per_branch = 1;
+    memcpy(head->anchor[0], anchor0, sizeof(anchor0));
+    memcpy(head->anchor[1], anchor1, sizeof(anchor1));
+    memcpy(head->anchor[2], anchor2, sizeof(anchor2));
+  }
+  else if (n_output == YOLO_BRANCH_NUM * 2 || n_output == YOLO_BRANCH_NUM * 3)
+  {
+    get_output_chw(&output_attrs[0], &c, &h, &w);
+    if (c != 4 * YOLO_DFL_LEN)
+    {
+      printf("unsupported yolov8 head: box channel %d\n", c);
+      return -1;
+    }
+    head->type = YOLO_HEAD_V8;
+    head->output_per_branch = n_output / YOLO_BRANCH_NUM;
+    get_output_chw(&output_attrs[1], &c, &h, &w);
+    head->class_num = c;
+  }
+  else
+  {
+    printf("unsupported model output number: %d\n", n_output);
+    return -1;
+  }
+
+  for (int b = 0; b < YOLO_BRANCH_NUM; b++)
+  {
+    get_output_chw(&output_attrs[b * head->output_per_branch], &c, &h, &w);
+    if (h <= 0 || w <= 0)
+    {
+      printf("invalid output grid: %dx%d\n", w, h);
+      return -1;
+    }
+    // 解码只用一个步长，要求横纵方向下采样倍数一致且能整除输入尺寸
+    if (model_in_h % h != 0 || model_in_w % w != 0 || model_in_h / h != model_in_w / w)
+    {
+      printf("output grid %dx%d does not match model input %dx%d\n", w, h, model_in_w, model_in_h);
+      return -1;
     }
+    head->grid_h[b] = h;
+    head->grid_w[b] = w;
+    head->stride[b] = model_in_h / h;
+  }
+
+  static const char *head_names[] = {"v5", "v8", "v5-seg"};
+  printf("yolo head: %s, %d classes, strides %d/%d/%d\n", head_names[head->type], head->class_num, head->stride[0],
+         head->stride[1], head->stride[2]);
+  if (head->type == YOLO_HEAD_V5_SEG)
+  {
+    printf("yolo head: %d mask coefficients, proto %dx%d\n", head->mask_dim, head->proto_w, head->proto_h);
   }
-  return validCount;
+  return 0;
 }
 
-int post_process(int8_t *input0, int8_t *input1, int8_t *input2, int model_in_h, int model_in_w, float conf_threshold,
-                 float nms_threshold, BOX_RECT pads, float scale_w, float scale_h, std::vector<int32_t> &qnt_zps,
-                 std::vector<float> &qnt_scales, detect_result_group_t *group)
+/**
+ * 初始化后处理上下文：推断检测头、构建每个输出的查找表、加载类别名
+ * 返回 0 成功，-1 失败
+ */
+int init_post_process(post_process_ctx_t *ctx, const rknn_tensor_attr *output_attrs, int n_output, int model_in_h,
+                      int model_in_w, const char *label_path)
 {
-  static int init = -1;
-  if (init == -1)
+  if (init_yolo_head(&ctx->head, output_attrs, n_output, model_in_h, model_in_w) < 0)
   {
-    int ret = 0;
-    ret = loadLabelName(LABEL_NALE_TXT_PATH, labels);
-    if (ret < 0)
+    return -1;
+  }
+
+  ctx->conf_threshold = BOX_THRESH;
+  ctx->nms_threshold = NMS_THRESH;
+  ctx->luts.resize(n_output);
+  for (int i = 0; i < n_output; i++)
+  {
+    init_qnt_lut(&ctx->luts[i], output_attrs[i].zp, output_attrs[i].scale, ctx->conf_threshold);
+  }
+
+  ctx->filter.ids.clear();
+  ctx->filter.thres.assign(ctx->head.class_num, ctx->conf_threshold);
+  ctx->filter.thres_set.assign(ctx->head.class_num, 0);
+  ctx->use_filter = false;
+  ctx->gate_threshold = ctx->conf_threshold;
+
+  if (loadLabelName(label_path, ctx->labels, ctx->head.class_num) < 0)
+  {
+    // 没有标签文件也能继续检测，类别名统一为 unknown
+    ctx->labels.assign(ctx->head.class_num, "unknown");
+  }
+  return 0;
+}
+
+/**
+ * 动态输入模型切换输入尺寸后重新推断各分支的网格和步长，查找表、类别过滤和阈值保持不变
+ * 返回 0 成功，-1 表示新输出布局与原检测头不一致
+ */
+int post_process_set_input_size(post_process_ctx_t *ctx, const rknn_tensor_attr *output_attrs, int n_output,
+                                int model_in_h, int model_in_w)
+{
+  yolo_head_t head;
+  if (init_yolo_head(&head, output_attrs, n_output, model_in_h, model_in_w) < 0)
+  {
+    return -1;
+  }
+  if (head.type != ctx->head.type || head.class_num != ctx->head.class_num || n_output != (int)ctx->luts.size())
+  {
+    printf("output layout changed after resize, keep previous head\n");
+    return -1;
+  }
+  ctx->head = head;
+  return 0;
+}
+
+// 重新计算解码阈值：量化比较必须放行所有关注类别中阈值最低的那个
+static void update_class_gate(post_process_ctx_t *ctx)
+{
+  const class_filter_t &filter = ctx->filter;
+  ctx->use_filter = !filter.ids.empty();
+  ctx->gate_threshold = ctx->conf_threshold;
+  for (int c = 0; c < ctx->head.class_num; c++)
+  {
+    if (!filter.ids.empty() && !std::binary_search(filter.ids.begin(), filter.ids.end(), c))
+    {
+      continue;
+    }
+    if (filter.thres[c] != ctx->conf_threshold)
+    {
+      ctx->use_filter = true;
+    }
+    ctx->gate_threshold = std::min(ctx->gate_threshold, filter.thres[c]);
+  }
+}
+
+/**
+ * 设置关注的类别，解码时跳过其余类别通道，class_ids 为空表示恢复全部类别
+ * 返回 0 成功，类别 id 越界返回 -1
+ */
+int post_process_set_class_filter(post_process_ctx_t *ctx, const std::vector<int> &class_ids)
+{
+  std::vector<int> ids;
+  for (int id : class_ids)
+  {
+    if (id < 0 || id >= ctx->head.class_num)
     {
+      printf("Invalid class id %d, model has %d classes\n", id, ctx->head.class_num);
       return -1;
     }
+    ids.push_back(id);
+  }
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  ctx->filter.ids = ids;
+  update_class_gate(ctx);
+  return 0;
+}
 
-    init = 0;
+/**
+ * 设置全局置信度阈值，没有单独设置过阈值的类别随之更新
+ * 返回 0 成功，参数非法返回 -1
+ */
+int post_process_set_conf_threshold(post_process_ctx_t *ctx, float threshold)
+{
+  if (threshold <= 0.0f || threshold >= 1.0f)
+  {
+    printf("Invalid confidence threshold: %.2f\n", threshold);
+    return -1;
+  }
+  for (int c = 0; c < ctx->head.class_num; c++)
+  {
+    if (!ctx->filter.thres_set[c])
+    {
+      ctx->filter.thres[c] = threshold;
+    }
   }
+  ctx->conf_threshold = threshold;
+  update_class_gate(ctx);
+  return 0;
+}
+
+/**
+ * 单独设置某个类别的置信度阈值
+ * 返回 0 成功，参数非法返回 -1
+ */
+int post_process_set_class_threshold(post_process_ctx_t *ctx, int class_id, float threshold)
+{
+  if (class_id < 0 || class_id >= ctx->head.class_num || threshold <= 0.0f || threshold >= 1.0f)
+  {
+    printf("Invalid class threshold: class %d, threshold %.2f\n", class_id, threshold);
+    return -1;
+  }
+  ctx->filter.thres[class_id] = threshold;
+  ctx->filter.thres_set[class_id] = 1;
+  update_class_gate(ctx);
+  return 0;
+}
+
+int post_process(post_process_ctx_t *ctx, int8_t **inputs, int model_in_h, int model_in_w, BOX_RECT pads,
+                 float scale_w, float scale_h, detect_result_group_t *group, std::vector<seg_mask_t> *masks)
+{
   memset(group, 0, sizeof(detect_result_group_t));
+  if (masks != nullptr)
+  {
+    masks->clear();
+  }
+
+  const yolo_head_t *head = &ctx->head;
+  const class_filter_t *filter = ctx->use_filter ? &ctx->filter : nullptr;
+  float conf_threshold = filter ? ctx->gate_threshold : ctx->conf_threshold;
+  qnt_lut_t *luts = ctx->luts.data();
+
+  // 阈值变化时才重新量化，LUT 本身只依赖 zp/scale
+  int n_output = (int)ctx->luts.size();
+  for (int i = 0; i < n_output; i++)
+  {
+    if (luts[i].thres != conf_threshold)
+    {
+      luts[i].thres = conf_threshold;
+      luts[i].thres_i8 = qnt_f32_to_affine(conf_threshold, luts[i].zp, luts[i].scale);
+    }
+  }
+
+  std::vector<float> &filterBoxes = ctx->filterBoxes;
+  std::vector<float> &objProbs = ctx->objProbs;
+  std::vector<int> &classId = ctx->classId;
+  std::vector<float> &maskCoefs = ctx->maskCoefs;
+  filterBoxes.clear();
+  objProbs.clear();
+  classId.clear();
+  maskCoefs.clear();
+
+  // 常见类别数走编译期特化的解码器，其余走运行时类别数的通用版本
+  int validCount = 0;
+  switch (head->class_num)
+  {
+  case 80:
+    validCount = decode_yolo_head<80>(inputs, head, luts, filter, filterBoxes, objProbs, classId, &maskCoefs);
+    break;
+  case 3:
+    validCount = decode_yolo_head<3>(inputs, head, luts, filter, filterBoxes, objProbs, classId, &maskCoefs);
+    break;
+  case 1:
+    validCount = decode_yolo_head<1>(inputs, head, luts, filter, filterBoxes, objProbs, classId, &maskCoefs);
+    break;
+  default:
+    validCount = decode_yolo_head<0>(inputs, head, luts, filter, filterBoxes, objProbs, classId, &maskCoefs);
+    break;
+  }
 
-  std::vector<float> filterBoxes;
-  std::vector<float> objProbs;
-  std::vector<int> classId;
-
-  // stride 8
-  int stride0 = 8;
-  int grid_h0 = model_in_h / stride0;
-  int grid_w0 = model_in_w / stride0;
-  int validCount0 = 0;
-  validCount0 = process(input0, (int *)anchor0, grid_h0, grid_w0, model_in_h, model_in_w, stride0, filterBoxes, objProbs,
-                        classId, conf_threshold, qnt_zps[0], qnt_scales[0]);
-
-  // stride 16
-  int stride1 = 16;
-  int grid_h1 = model_in_h / stride1;
-  int grid_w1 = model_in_w / stride1;
-  int validCount1 = 0;
-  validCount1 = process(input1, (int *)anchor1, grid_h1, grid_w1, model_in_h, model_in_w, stride1, filterBoxes, objProbs,
-                        classId, conf_threshold, qnt_zps[1], qnt_scales[1]);
-
-  // stride 32
-  int stride2 = 32;
-  int grid_h2 = model_in_h / stride2;
-  int grid_w2 = model_in_w / stride2;
-  int validCount2 = 0;
-  validCount2 = process(input2, (int *)anchor2, grid_h2, grid_w2, model_in_h, model_in_w, stride2, filterBoxes, objProbs,
-                        classId, conf_threshold, qnt_zps[2], qnt_scales[2]);
-
-  int validCount = validCount0 + validCount1 + validCount2;
   // no object detect
   if (validCount <= 0)
   {
     return 0;
   }
 
-  std::vector<int> indexArray;
+  std::vector<int> &indexArray = ctx->indexArray;
+  indexArray.clear();
   for (int i = 0; i < validCount; ++i)
   {
     indexArray.push_back(i);
@@ -318,11 +521,14 @@ int post_process(int8_t *input0, int8_t *input1, int8_t *input2, int model_in_h,
 
   quick_sort_indice_inverse(objProbs, 0, validCount - 1, indexArray);
 
-  std::set<int> class_set(std::begin(classId), std::end(classId));
+  std::vector<int> &classList = ctx->classList;
+  classList.assign(classId.begin(), classId.end());
+  std::sort(classList.begin(), classList.end());
+  classList.erase(std::unique(classList.begin(), classList.end()), classList.end());
 
-  for (auto c : class_set)
+  for (auto c : classList)
   {
-    nms(validCount, filterBoxes, classId, indexArray, c, nms_threshold);
+    nms(validCount, filterBoxes, classId, indexArray, c, ctx->nms_threshold);
   }
 
   int last_count = 0;
@@ -342,6 +548,11 @@ int post_process(int8_t *input0, int8_t *input1, int8_t *input2, int model_in_h,
     float y2 = y1 + filterBoxes[n * 4 + 3];
     int id = classId[n];
     float obj_conf = objProbs[i];
+    // 过滤低置信度结果
+    if (obj_conf < (filter ? filter->thres[id] : ctx->conf_threshold))
+    {
+      continue;
+    }
 
     group->results[last_count].box.left = (int)(clamp(x1, 0, model_in_w) / scale_w);
     group->results[last_count].box.top = (int)(clamp(y1, 0, model_in_h) / scale_h);
@@ -349,8 +560,24 @@ int post_process(int8_t *input0, int8_t *input1, int8_t *input2, int model_in_h,
     group->results[last_count].box.bottom = (int)(clamp(y2, 0, model_in_h) / scale_h);
     group->results[last_count].prop = obj_conf;
     group->results[last_count].class_index = id;
-    char *label = labels[id];
-    strncpy(group->results[last_count].name, label, OBJ_NAME_MAX_SIZE);
+    const char *label = ctx->labels[id].c_str();
+    strncpy(group->results[last_count].name, label, OBJ_NAME_MAX_SIZE - 1);
+
+    // 掩码只为 NMS 后保留下来的框生成，且只计算框内的原型像素
+    if (masks != nullptr && head->type == YOLO_HEAD_V5_SEG)
+    {
+      masks->resize(last_count + 1);
+      build_roi_mask(inputs[n_output - 1], head->mask_dim, head->proto_h, head->proto_w, luts[n_output - 1].zp,
+                     &maskCoefs[n * head->mask_dim], filterBoxes[n * 4 + 0], filterBoxes[n * 4 + 1],
+                     filterBoxes[n * 4 + 0] + filterBoxes[n * 4 + 2], filterBoxes[n * 4 + 1] + filterBoxes[n * 4 + 3],
+                     model_in_h, model_in_w, &(*masks)[last_count]);
+      // 掩码网格换算到输出图像坐标，与检测框一致
+      seg_mask_t &mask = (*masks)[last_count];
+      mask.origin_x = (mask.origin_x - pads.left) / scale_w;
+      mask.origin_y = (mask.origin_y - pads.top) / scale_h;
+      mask.stride_x /= scale_w;
+      mask.stride_y /= scale_h;
+    }
 
     // printf("result %2d: (%4d, %4d, %4d, %4d), %s\n", i, group->results[last_count].box.left,
     // group->results[last_count].box.top,
@@ -362,14 +589,17 @@ int post_process(int8_t *input0, int8_t *input1, int8_t *input2, int model_in_h,
   return 0;
 }
 
-void deinitPostProcess()
+void deinit_post_process(post_process_ctx_t *ctx)
 {
-  for (int i = 0; i < OBJ_CLASS_NUM; i++)
-  {
-    if (labels[i] != nullptr)
-    {
-      free(labels[i]);
-      labels[i] = nullptr;
-    }
-  }
+  ctx->luts.clear();
+  ctx->labels.clear();
+  ctx->filter.ids.clear();
+  ctx->filter.thres.clear();
+  ctx->use_filter = false;
+  std::vector<float>().swap(ctx->filterBoxes);
+  std::vector<float>().swap(ctx->objProbs);
+  std::vector<int>().swap(ctx->classId);
+  std::vector<int>().swap(ctx->indexArray);
+  std::vector<int>().swap(ctx->classList);
+  std::vector<float>().swap(ctx->maskCoefs);
 }
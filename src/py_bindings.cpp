@@ -0,0 +1,240 @@
+/*
+    Python 绑定 (pybind11)：模块名 bricsbot_native
+    - DmaFrame:      DMA 帧缓冲，实现缓冲区协议，np.asarray(frame) 直接得到 (H, W, C) 的 uint8 视图，不拷贝
+    - RKNNDetector:  C++ 检测器，detect() 返回 (boxes, classes, scores) 三个 NumPy 数组
+    - PostProcessor: 单独的 int8 后处理 (解码 + NMS)，输入为 NPU 原始输出张量
+
+    返回的 NumPy 数组直接引用 C++ 侧分配的内存 (由 capsule 负责释放)，不再逐个元素转换；
+    推理和后处理期间释放 GIL，Python 侧的其它线程 (如 ROS 回调) 可以并行执行。
+*/
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "yolo_detector.h"
+#include "postprocess.h"
+#include "dma_utils.h"
+
+namespace py = pybind11;
+
+/**
+ * @brief  把 vector 移交给 NumPy 数组，数组释放时由 capsule 删除 vector
+**/
+template<typename T>
+static py::array_t<T> vector_to_array(std::vector<T>&& v, const std::vector<py::ssize_t>& shape){
+    std::vector<T>* owner = new std::vector<T>(std::move(v));
+    py::capsule free_when_done(owner, [](void* p){ delete reinterpret_cast<std::vector<T>*>(p); });
+    return py::array_t<T>(shape, owner->data(), free_when_done);
+}
+
+/**
+ * @brief  检测结果转换为 (boxes[N,4] int32, classes[N] int32, scores[N] float32)
+ * @remark 与 python_demo/yolov5_rknn.py 中 yolov5_post_process 的返回顺序一致
+**/
+static py::tuple results_to_arrays(const std::vector<DetectResult>& results){
+    const py::ssize_t n = (py::ssize_t)results.size();
+    std::vector<int32_t> boxes(n * 4);
+    std::vector<int32_t> classes(n);
+    std::vector<float> scores(n);
+    for(py::ssize_t i=0;i<n;i++){
+        const DetectResult& r = results[i];
+        boxes[i * 4 + 0] = r.box.left;
+        boxes[i * 4 + 1] = r.box.top;
+        boxes[i * 4 + 2] = r.box.right;
+        boxes[i * 4 + 3] = r.box.bottom;
+        classes[i] = r.id;
+        scores[i] = r.confidence;
+    }
+    return py::make_tuple(vector_to_array(std::move(boxes), {n, 4}),
+                          vector_to_array(std::move(classes), {n}),
+                          vector_to_array(std::move(scores), {n}));
+}
+
+static py::tuple group_to_arrays(const detect_result_group_t& group){
+    std::vector<DetectResult> results(group.count);
+    for(int i=0;i<group.count;i++){
+        results[i].id = group.results[i].class_index;
+        results[i].confidence = group.results[i].prop;
+        results[i].track_id = -1;
+        results[i].box.left = group.results[i].box.left;
+        results[i].box.top = group.results[i].box.top;
+        results[i].box.right = group.results[i].box.right;
+        results[i].box.bottom = group.results[i].box.bottom;
+    }
+    return results_to_arrays(results);
+}
+
+/**
+ * @brief  实例掩码转换为 list[(bitmap[h,w] uint8, (origin_x, origin_y), (stride_x, stride_y))]
+ * @remark 检测器的掩码每帧复用，这里拷贝一份位图 (ROI 内、原型分辨率，通常只有几 KB)
+**/
+static py::list masks_to_list(const std::vector<seg_mask_t>& masks){
+    py::list out;
+    for(const auto& m : masks){
+        std::vector<uint8_t> bitmap(m.bitmap);
+        out.append(py::make_tuple(vector_to_array(std::move(bitmap), {m.height, m.width}),
+                                  py::make_tuple(m.origin_x, m.origin_y),
+                                  py::make_tuple(m.stride_x, m.stride_y)));
+    }
+    return out;
+}
+
+// DMA 帧缓冲：CPU 写入后可直接交给 RGA/NPU (fd)，Python 侧通过缓冲区协议零拷贝访问
+class DmaFrame {
+public:
+    DmaFrame(int width, int height, int channels) : width(width), height(height), channels(channels) {
+        if(width <= 0 || height <= 0 || channels <= 0){
+            throw py::value_error("invalid DmaFrame size");
+        }
+        if(alloc_dma_buffer((size_t)width * height * channels, &buf) < 0){
+            throw std::runtime_error("alloc_dma_buffer failed");
+        }
+    }
+    ~DmaFrame(){ free_dma_buffer(&buf); }
+    DmaFrame(const DmaFrame&) = delete;
+    DmaFrame& operator=(const DmaFrame&) = delete;
+
+    DmaBuffer buf;
+    int width, height, channels;
+};
+
+// 单独的后处理器：用于回放录制的张量，或 Python 侧已经拿到 int8 原始输出的场景
+class PostProcessor {
+public:
+    /**
+     * @param shapes      每个输出的 NCHW 形状
+     * @param zps         每个输出的量化零点
+     * @param scales      每个输出的量化尺度
+     * @param label_path  标签文件路径
+    **/
+    PostProcessor(const std::vector<std::vector<int> >& shapes, const std::vector<int>& zps,
+                  const std::vector<float>& scales, int model_height, int model_width, const std::string& label_path)
+        : model_height(model_height), model_width(model_width) {
+        if(shapes.empty() || shapes.size() != zps.size() || shapes.size() != scales.size()){
+            throw py::value_error("shapes, zps and scales must have the same non-zero length");
+        }
+        attrs.resize(shapes.size());
+        memset(attrs.data(), 0, attrs.size() * sizeof(rknn_tensor_attr));
+        for(size_t i=0;i<shapes.size();i++){
+            if(shapes[i].size() != 4) throw py::value_error("output shape must be NCHW");
+            rknn_tensor_attr& a = attrs[i];
+            a.index = (uint32_t)i;
+            a.fmt = RKNN_TENSOR_NCHW;
+            a.type = RKNN_TENSOR_INT8;
+            a.n_dims = 4;
+            a.n_elems = 1;
+            for(int d=0;d<4;d++){
+                a.dims[d] = shapes[i][d];
+                a.n_elems *= shapes[i][d];
+            }
+            a.size = a.n_elems;
+            a.zp = zps[i];
+            a.scale = scales[i];
+        }
+        if(init_post_process(&ctx, attrs.data(), (int)attrs.size(), model_height, model_width, label_path.c_str()) < 0){
+            throw std::runtime_error("init_post_process failed");
+        }
+    }
+    ~PostProcessor(){ deinit_post_process(&ctx); }
+
+    py::tuple process(const std::vector<py::array_t<int8_t, py::array::c_style> >& outputs,
+                      float scale_w, float scale_h){
+        if(outputs.size() != attrs.size()) throw py::value_error("output count mismatch");
+        std::vector<int8_t*> bufs(outputs.size());
+        for(size_t i=0;i<outputs.size();i++){
+            if((uint32_t)outputs[i].size() != attrs[i].n_elems) throw py::value_error("output size mismatch");
+            bufs[i] = const_cast<int8_t*>(outputs[i].data());
+        }
+        BOX_RECT pads;
+        memset(&pads, 0, sizeof(pads));
+        detect_result_group_t group;
+        {
+            py::gil_scoped_release release;
+            post_process(&ctx, bufs.data(), model_height, model_width, pads, scale_w, scale_h, &group);
+        }
+        return group_to_arrays(group);
+    }
+
+    void set_conf_threshold(float threshold){ post_process_set_conf_threshold(&ctx, threshold); }
+
+private:
+    post_process_ctx_t ctx;
+    std::vector<rknn_tensor_attr> attrs;
+    int model_height, model_width;
+};
+
+/**
+ * @brief  对一张模型输入尺寸的 RGB 图像 (H, W, 3) 做推理
+ * @remark 传入 DmaFrame 或 C 连续的 uint8 数组时不会拷贝
+**/
+static py::tuple detector_detect(RKNNDetector& det, py::array_t<uint8_t, py::array::c_style> img){
+    if(img.ndim() != 3 || img.shape(0) != det.model_height() || img.shape(1) != det.model_width() || img.shape(2) != 3){
+        throw py::value_error("image must be (" + std::to_string(det.model_height()) + ", " +
+                              std::to_string(det.model_width()) + ", 3) uint8");
+    }
+    std::vector<DetectResult> results;
+    int ret;
+    {
+        py::gil_scoped_release release;
+        ret = det.inference(img.mutable_data(), results);
+    }
+    if(ret < 0) throw std::runtime_error("inference failed");
+    return results_to_arrays(results);
+}
+
+PYBIND11_MODULE(bricsbot_native, m){
+    m.doc() = "RKNN YOLO detector, int8 post-processing and DMA frame buffers";
+
+    py::class_<DmaFrame>(m, "DmaFrame", py::buffer_protocol())
+        .def(py::init<int, int, int>(), py::arg("width"), py::arg("height"), py::arg("channels") = 3)
+        .def_buffer([](DmaFrame& f) -> py::buffer_info {
+            return py::buffer_info(f.buf.vaddr, 1, py::format_descriptor<uint8_t>::format(), 3,
+                                   {f.height, f.width, f.channels},
+                                   {f.width * f.channels, f.channels, 1});
+        })
+        .def_property_readonly("fd", [](const DmaFrame& f){ return f.buf.fd; })
+        .def_readonly("width", &DmaFrame::width)
+        .def_readonly("height", &DmaFrame::height)
+        .def_readonly("channels", &DmaFrame::channels)
+        .def("sync_cpu", [](DmaFrame& f){ dma_sync_cpu(f.buf.fd); }, "CPU 读取设备写入的数据前调用")
+        .def("sync_device", [](DmaFrame& f){ dma_sync_device(f.buf.fd); }, "CPU 写入后、交给设备前调用");
+
+    py::class_<RKNNDetector>(m, "RKNNDetector")
+        .def(py::init<>())
+        .def("init", &RKNNDetector::init, py::arg("model_path"), py::arg("label_path") = LABEL_NALE_TXT_PATH)
+        .def("init_replay", &RKNNDetector::init_replay, py::arg("capture_dir"),
+             py::arg("label_path") = LABEL_NALE_TXT_PATH)
+        .def("detect", &detector_detect, py::arg("image"),
+             "推理一帧，返回 (boxes[N,4] int32, classes[N] int32, scores[N] float32)")
+        .def("masks", [](const RKNNDetector& det){ return masks_to_list(det.last_masks()); },
+             "最近一帧的实例掩码 (仅分割模型)，与 detect 的结果按下标对应")
+        .def("set_conf_threshold", &RKNNDetector::set_conf_threshold)
+        .def("set_class_threshold", &RKNNDetector::set_class_threshold)
+        .def("set_class_filter", &RKNNDetector::set_class_filter)
+        .def("set_core_mask", [](RKNNDetector& det, int core_mask){
+            return det.set_core_mask((rknn_core_mask)core_mask);
+        })
+        .def("set_output_size", &RKNNDetector::set_output_size)
+        .def("set_input_size", &RKNNDetector::set_input_size)
+        .def("load_model_async", &RKNNDetector::load_model_async, py::arg("model_path"),
+             py::arg("label_path") = LABEL_NALE_TXT_PATH)
+        .def_property_readonly("swap_pending", &RKNNDetector::swap_pending)
+        .def_property_readonly("current_model", &RKNNDetector::current_model)
+        .def_property_readonly("model_width", &RKNNDetector::model_width)
+        .def_property_readonly("model_height", &RKNNDetector::model_height)
+        .def_property_readonly("is_dynamic", &RKNNDetector::is_dynamic)
+        .def_property_readonly("is_segmentation", &RKNNDetector::is_segmentation);
+
+    py::class_<PostProcessor>(m, "PostProcessor")
+        .def(py::init<const std::vector<std::vector<int> >&, const std::vector<int>&, const std::vector<float>&,
+                      int, int, const std::string&>(),
+             py::arg("shapes"), py::arg("zps"), py::arg("scales"), py::arg("model_height"), py::arg("model_width"),
+             py::arg("label_path") = LABEL_NALE_TXT_PATH)
+        .def("process", &PostProcessor::process, py::arg("outputs"), py::arg("scale_w") = 1.0f,
+             py::arg("scale_h") = 1.0f, "int8 原始输出 -> (boxes, classes, scores)")
+        .def("set_conf_threshold", &PostProcessor::set_conf_threshold);
+}
@@ -0,0 +1,76 @@
+#include "resolution_policy.h"
+#include <algorithm>
+
+ResolutionPolicy::ResolutionPolicy(const ResolutionPolicyConfig& cfg)
+    : cfg(cfg), current(0), proposed(-1), ema_us(0.0f), has_ema(false), since_switch(0), switches(0) {
+}
+
+void ResolutionPolicy::set_sizes(const std::vector<InputSize>& sizes, int current_width, int current_height){
+    this->sizes = sizes;
+    current = (int)sizes.size() - 1;
+    for(size_t i=0;i<sizes.size();i++){
+        if(sizes[i].width == current_width && sizes[i].height == current_height) current = (int)i;
+    }
+    proposed = -1;
+    has_ema = false;
+    since_switch = 0;
+}
+
+/**
+ * @brief  根据本次推理的耗时和检测结果决定是否切换输入尺寸
+ * @param  infer_us 本次推理耗时 (微秒)
+ * @param  results  本次检测结果
+ * @param  next     需要切换时输出新的输入尺寸
+ * @return true 建议切换，false 保持当前尺寸
+ * @remark 推理耗时近似与输入面积成正比，升档前按面积比例预估新的耗时。
+ *         返回 true 后当前档位不变，直到调用方根据切换结果调用 commit 或 reject。
+**/
+bool ResolutionPolicy::update(int64_t infer_us, const std::vector<DetectResult>& results, InputSize& next){
+    if(sizes.size() < 2 || proposed >= 0) return false;
+
+    ema_us = has_ema ? ema_us * (1.0f - cfg.ema_alpha) + infer_us * cfg.ema_alpha : (float)infer_us;
+    has_ema = true;
+    if(++since_switch < cfg.hold_frames) return false;
+
+    bool has_small = false;
+    bool all_large = !results.empty();
+    for(const auto& r : results){
+        int side = std::min(r.box.right - r.box.left, r.box.bottom - r.box.top);
+        if(side < cfg.small_box) has_small = true;
+        if(side < cfg.small_box * 2) all_large = false;
+    }
+    bool complex = has_small || (int)results.size() >= cfg.crowded_count;
+
+    float budget_us = cfg.latency_budget_ms * 1000.0f;
+    int target = current;
+    if(ema_us > budget_us && current > 0){
+        target = current - 1;
+    }
+    else if(complex && current + 1 < (int)sizes.size()){
+        float ratio = (float)(sizes[current + 1].width * sizes[current + 1].height) /
+                      (sizes[current].width * sizes[current].height);
+        if(ema_us * ratio <= budget_us) target = current + 1;
+    }
+    else if(all_large && current > 0){
+        target = current - 1;
+    }
+
+    if(target == current) return false;
+    proposed = target;
+    next = sizes[target];
+    return true;
+}
+
+void ResolutionPolicy::commit(){
+    if(proposed < 0) return;
+    current = proposed;
+    proposed = -1;
+    has_ema = false;
+    since_switch = 0;
+    switches++;
+}
+
+void ResolutionPolicy::reject(){
+    proposed = -1;
+    since_switch = 0;
+}
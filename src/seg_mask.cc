@@ -0,0 +1,112 @@
+#include "seg_mask.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SEG_MASK_NEON 1
+#else
+#define SEG_MASK_NEON 0
+#endif
+
+#define SEG_MAX_MASK_DIM 64
+
+void build_roi_mask(const int8_t *proto, int mask_dim, int proto_h, int proto_w, int32_t proto_zp,
+                    const float *coefs, float x1, float y1, float x2, float y2, int model_in_h, int model_in_w,
+                    seg_mask_t *mask)
+{
+  mask->stride_x = (float)model_in_w / proto_w;
+  mask->stride_y = (float)model_in_h / proto_h;
+
+  // 检测框换算到原型网格，向外取整保证边缘像素被覆盖
+  int left = std::max(0, (int)floorf(x1 / mask->stride_x));
+  int top = std::max(0, (int)floorf(y1 / mask->stride_y));
+  int right = std::min(proto_w, (int)ceilf(x2 / mask->stride_x));
+  int bottom = std::min(proto_h, (int)ceilf(y2 / mask->stride_y));
+  mask->left = left;
+  mask->top = top;
+  mask->origin_x = left * mask->stride_x;
+  mask->origin_y = top * mask->stride_y;
+  mask->width = std::max(0, right - left);
+  mask->height = std::max(0, bottom - top);
+  mask->bitmap.assign(mask->width * mask->height, 0);
+  if (mask->width == 0 || mask->height == 0 || mask_dim > SEG_MAX_MASK_DIM)
+  {
+    return;
+  }
+
+  // 系数按框对称量化到 int8，符号判断与量化尺度无关
+  float max_abs = 0.0f;
+  for (int k = 0; k < mask_dim; k++)
+  {
+    max_abs = std::max(max_abs, fabsf(coefs[k]));
+  }
+  if (max_abs <= 0.0f)
+  {
+    return;
+  }
+  int8_t coef_i8[SEG_MAX_MASK_DIM];
+  int32_t coef_sum = 0;
+  for (int k = 0; k < mask_dim; k++)
+  {
+    coef_i8[k] = (int8_t)lrintf(coefs[k] * 127.0f / max_abs);
+    coef_sum += coef_i8[k];
+  }
+  const int32_t bias = -proto_zp * coef_sum;
+  const int plane = proto_h * proto_w;
+
+  for (int y = 0; y < mask->height; y++)
+  {
+    const int8_t *row = proto + (top + y) * proto_w + left;
+    uint8_t *out = mask->bitmap.data() + y * mask->width;
+    int x = 0;
+#if SEG_MASK_NEON
+    // 一次处理 8 个像素：逐通道 int8 乘法 (结果在 int16 内)，累加到两组 int32
+    const int32x4_t vbias = vdupq_n_s32(bias);
+    for (; x + 8 <= mask->width; x += 8)
+    {
+      int32x4_t acc_lo = vbias;
+      int32x4_t acc_hi = vbias;
+      for (int k = 0; k < mask_dim; k++)
+      {
+        int16x8_t prod = vmull_s8(vld1_s8(row + k * plane + x), vdup_n_s8(coef_i8[k]));
+        acc_lo = vaddw_s16(acc_lo, vget_low_s16(prod));
+        acc_hi = vaddw_s16(acc_hi, vget_high_s16(prod));
+      }
+      uint16x8_t pos = vcombine_u16(vmovn_u32(vcgtq_s32(acc_lo, vdupq_n_s32(0))),
+                                    vmovn_u32(vcgtq_s32(acc_hi, vdupq_n_s32(0))));
+      vst1_u8(out + x, vshr_n_u8(vmovn_u16(pos), 7));
+    }
+#endif
+    for (; x < mask->width; x++)
+    {
+      int32_t acc = bias;
+      for (int k = 0; k < mask_dim; k++)
+      {
+        acc += (int32_t)coef_i8[k] * row[k * plane + x];
+      }
+      out[x] = acc > 0 ? 1 : 0;
+    }
+  }
+}
+
+void seg_mask_to_rle(const seg_mask_t *mask, std::vector<uint32_t> &rle)
+{
+  rle.clear();
+  uint8_t cur = 0;
+  uint32_t run = 0;
+  for (uint8_t v : mask->bitmap)
+  {
+    if (v != cur)
+    {
+      rle.push_back(run);
+      cur = v;
+      run = 0;
+    }
+    run++;
+  }
+  rle.push_back(run);
+}
@@ -0,0 +1,162 @@
+#include "tensor_replay.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+static std::string frame_path(const std::string& dir, int idx){
+    char name[32];
+    snprintf(name, sizeof(name), "/frame_%06d.bin", idx);
+    return dir + name;
+}
+
+TensorRecorder::TensorRecorder() : frames(0), max_frames(0) {
+}
+
+/**
+ * @brief  打开录制目录并写入输出属性
+ * @param  dir        录制目录，不存在时自动创建
+ * @param  attrs      模型输出属性 (rknn_query RKNN_QUERY_OUTPUT_ATTR 的结果)
+ * @param  n_output   输出个数
+ * @param  model_w    模型输入宽度
+ * @param  model_h    模型输入高度
+ * @param  max_frames 最多录制的帧数，0 表示不限
+ * @return 0 成功，-1 失败
+**/
+int TensorRecorder::open(const std::string& dir, const rknn_tensor_attr* attrs, int n_output,
+                         int model_w, int model_h, int max_frames){
+    if(mkdir(dir.c_str(), 0755) < 0 && errno != EEXIST){
+        perror("mkdir capture dir failed");
+        return -1;
+    }
+
+    std::string path = dir + "/attrs.txt";
+    FILE* fp = fopen(path.c_str(), "w");
+    if(fp == nullptr){
+        printf("Failed to create %s\n", path.c_str());
+        return -1;
+    }
+    fprintf(fp, "model %d %d\n", model_w, model_h);
+    fprintf(fp, "outputs %d\n", n_output);
+    sizes.clear();
+    for(int i=0;i<n_output;i++){
+        const rknn_tensor_attr& a = attrs[i];
+        fprintf(fp, "output %u %d %u %u %u %u %u %d %.9g %u\n", a.index, (int)a.fmt, a.n_dims,
+                a.dims[0], a.dims[1], a.dims[2], a.dims[3], a.zp, a.scale, a.n_elems);
+        sizes.push_back(a.n_elems);
+    }
+    fclose(fp);
+
+    this->dir = dir;
+    this->frames = 0;
+    this->max_frames = max_frames;
+    printf("Tensor capture enabled: %s\n", dir.c_str());
+    return 0;
+}
+
+/**
+ * @brief  录制一帧原始 int8 输出
+ * @param  outputs 每个输出的数据指针，顺序与 open 时的属性一致
+ * @return 0 成功 (或已达到帧数上限)，-1 失败
+**/
+int TensorRecorder::write(int8_t** outputs){
+    if(dir.empty()) return -1;
+    if(max_frames > 0 && frames >= max_frames) return 0;
+
+    std::string path = frame_path(dir, frames);
+    FILE* fp = fopen(path.c_str(), "wb");
+    if(fp == nullptr){
+        printf("Failed to create %s\n", path.c_str());
+        return -1;
+    }
+    for(size_t i=0;i<sizes.size();i++){
+        if(fwrite(outputs[i], 1, sizes[i], fp) != sizes[i]){
+            printf("Failed to write %s\n", path.c_str());
+            fclose(fp);
+            return -1;
+        }
+    }
+    fclose(fp);
+    frames++;
+    return 0;
+}
+
+TensorReplayer::TensorReplayer() : model_w(0), model_h(0), cursor(0) {
+}
+
+/**
+ * @brief  加载录制目录，全部帧一次性读入内存，回放时不再有文件 IO
+ * @param  dir 录制目录
+ * @return 0 成功，-1 失败
+**/
+int TensorReplayer::open(const std::string& dir){
+    std::string path = dir + "/attrs.txt";
+    FILE* fp = fopen(path.c_str(), "r");
+    if(fp == nullptr){
+        printf("Failed to open %s\n", path.c_str());
+        return -1;
+    }
+
+    int n_output = 0;
+    if(fscanf(fp, "model %d %d\n", &model_w, &model_h) != 2 || fscanf(fp, "outputs %d\n", &n_output) != 1 ||
+       n_output <= 0){
+        printf("Invalid attrs file: %s\n", path.c_str());
+        fclose(fp);
+        return -1;
+    }
+
+    attrs.assign(n_output, rknn_tensor_attr());
+    size_t frame_size = 0;
+    for(int i=0;i<n_output;i++){
+        rknn_tensor_attr& a = attrs[i];
+        memset(&a, 0, sizeof(a));
+        int fmt = 0;
+        if(fscanf(fp, "output %u %d %u %u %u %u %u %d %f %u\n", &a.index, &fmt, &a.n_dims,
+                  &a.dims[0], &a.dims[1], &a.dims[2], &a.dims[3], &a.zp, &a.scale, &a.n_elems) != 10){
+            printf("Invalid output attr %d in %s\n", i, path.c_str());
+            fclose(fp);
+            return -1;
+        }
+        a.fmt = (rknn_tensor_format)fmt;
+        a.type = RKNN_TENSOR_INT8;
+        a.qnt_type = RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC;
+        a.size = a.n_elems;
+        frame_size += a.n_elems;
+    }
+    fclose(fp);
+
+    frames.clear();
+    for(int idx=0;;idx++){
+        FILE* f = fopen(frame_path(dir, idx).c_str(), "rb");
+        if(f == nullptr) break;
+        std::vector<int8_t> data(frame_size);
+        size_t n = fread(data.data(), 1, frame_size, f);
+        fclose(f);
+        if(n != frame_size){
+            printf("Truncated frame %d in %s\n", idx, dir.c_str());
+            return -1;
+        }
+        frames.push_back(data);
+    }
+    cursor = 0;
+
+    printf("Tensor replay: %s, %d outputs, %d frames\n", dir.c_str(), n_output, (int)frames.size());
+    return frames.empty() ? -1 : 0;
+}
+
+int TensorReplayer::frame(int idx, int8_t** outputs){
+    if(idx < 0 || idx >= (int)frames.size()) return -1;
+    int8_t* ptr = frames[idx].data();
+    for(size_t i=0;i<attrs.size();i++){
+        outputs[i] = ptr;
+        ptr += attrs[i].n_elems;
+    }
+    return 0;
+}
+
+int TensorReplayer::next(int8_t** outputs){
+    if(frames.empty()) return -1;
+    int ret = frame(cursor, outputs);
+    cursor = (cursor + 1) % (int)frames.size();
+    return ret;
+}
@@ -0,0 +1,180 @@
+#include "tiled_detector.h"
+#include "count_utils.h"
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <algorithm>
+
+// 第 w 个 NPU 核心的核心掩码
+static const rknn_core_mask WORKER_CORES[3] = {RKNN_NPU_CORE_0, RKNN_NPU_CORE_1, RKNN_NPU_CORE_2};
+
+/**
+ * @brief  一维方向上的分块起点：分块数取满足重叠要求的最小值，起点均匀分布并保证最后一块贴齐边缘
+**/
+static std::vector<int> tile_starts(int length, int tile, int overlap){
+    std::vector<int> starts;
+    if(length <= tile){
+        starts.push_back(0);
+        return starts;
+    }
+    int step = std::max(1, tile - overlap);
+    int n = (length - tile + step - 1) / step + 1;
+    for(int i=0;i<n;i++){
+        starts.push_back((int)((int64_t)i * (length - tile) / (n - 1)));
+    }
+    return starts;
+}
+
+TiledDetector::TiledDetector(const TiledConfig& cfg) : cfg(cfg) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+TiledDetector::~TiledDetector(){
+    release();
+}
+
+void TiledDetector::release(){
+    for(auto& t : tiles){
+        free_dma_buffer(&t.buf);
+    }
+    tiles.clear();
+}
+
+void TiledDetector::plan_tiles(int frame_width, int frame_height, int tile_w, int tile_h){
+    std::vector<int> xs = tile_starts(frame_width, tile_w, cfg.overlap);
+    std::vector<int> ys = tile_starts(frame_height, tile_h, cfg.overlap);
+    for(int y : ys){
+        for(int x : xs){
+            Tile t;
+            memset(&t, 0, sizeof(t));
+            t.rect.x = x;
+            t.rect.y = y;
+            t.rect.width = std::min(tile_w, frame_width);
+            t.rect.height = std::min(tile_h, frame_height);
+            t.buf.fd = -1;
+            tiles.push_back(t);
+        }
+    }
+}
+
+/**
+ * @brief  初始化分块检测器
+ * @param  model_path   模型文件路径，每个 NPU 核心各加载一份
+ * @param  frame_width  输入帧宽度
+ * @param  frame_height 输入帧高度
+ * @param  label_path   类别名文件路径
+ * @return 成功返回0，失败返回-1。
+**/
+int TiledDetector::init(const std::string& model_path, int frame_width, int frame_height,
+                        const std::string& label_path){
+    int workers = std::max(1, std::min(cfg.workers, 3));
+    for(int w=0;w<workers;w++){
+        std::unique_ptr<RKNNDetector> det(new RKNNDetector());
+        if(det->init(model_path, label_path) < 0) return -1;
+        if(det->set_core_mask(WORKER_CORES[w]) < 0){
+            printf("Warning: tiled worker %d failed to bind NPU core\n", w);
+        }
+        detectors.push_back(std::move(det));
+    }
+
+    int tile_w = detectors[0]->model_width();
+    int tile_h = detectors[0]->model_height();
+    plan_tiles(frame_width, frame_height, tile_w, tile_h);
+
+    // 分块内存池：每个分块一块模型输入大小的 DMA 内存，初始化时一次性申请
+    for(auto& t : tiles){
+        if(alloc_dma_buffer(tile_w * tile_h * 3, &t.buf) < 0){
+            printf("Tile buffer alloc_dma_buffer failed\n");
+            release();
+            return -1;
+        }
+        t.img = wrapbuffer_fd(t.buf.fd, tile_w, tile_h, RK_FORMAT_RGB_888);
+    }
+
+    // 所有分块尺寸相同，检测框统一换算到分块在原始帧中的尺寸，再加上分块偏移
+    for(auto& det : detectors){
+        det->set_output_size(tiles[0].rect.width, tiles[0].rect.height);
+    }
+
+    tile_results.resize(tiles.size());
+    worker_crop_us.assign(workers, 0);
+    worker_infer_us.assign(workers, 0);
+    worker_ret.assign(workers, 0);
+    printf("Tiled detector: frame %dx%d, %d tiles of %dx%d, overlap >= %d, %d NPU workers\n",
+           frame_width, frame_height, (int)tiles.size(), tile_w, tile_h, cfg.overlap, workers);
+    return 0;
+}
+
+/**
+ * @brief  单个 NPU 核心的工作：依次裁剪并推理分给它的分块 (分块下标 i % workers == worker)
+**/
+void TiledDetector::run_worker(int worker, const rga_buffer_t& frame){
+    int workers = (int)detectors.size();
+    worker_crop_us[worker] = 0;
+    worker_infer_us[worker] = 0;
+    worker_ret[worker] = 0;
+    for(size_t i=worker;i<tiles.size();i+=workers){
+        Tile& t = tiles[i];
+        tile_results[i].clear();
+
+        int64_t t0 = now_us();
+        IM_STATUS status = imcrop(frame, t.img, t.rect);
+        int64_t t1 = now_us();
+        worker_crop_us[worker] += t1 - t0;
+        if(status != IM_STATUS_SUCCESS){
+            printf("RGA tile crop failed: %s\n", imStrError(status));
+            worker_ret[worker] = -1;
+            continue;
+        }
+
+        if(detectors[worker]->inference((unsigned char*)t.buf.vaddr, tile_results[i]) < 0){
+            worker_ret[worker] = -1;
+        }
+        worker_infer_us[worker] += now_us() - t1;
+    }
+}
+
+/**
+ * @brief  分块推理一帧
+ * @param  frame   整帧图像
+ * @param  results 输出整帧坐标下的检测结果
+ * @return 全部分块成功返回0，有分块失败返回-1 (其余分块的结果仍然输出)
+**/
+int TiledDetector::inference(const rga_buffer_t& frame, std::vector<DetectResult>& results){
+    int64_t t0 = now_us();
+    int workers = (int)detectors.size();
+    std::vector<std::thread> threads;
+    for(int w=1;w<workers;w++){
+        threads.emplace_back(&TiledDetector::run_worker, this, w, std::cref(frame));
+    }
+    run_worker(0, frame);
+    for(auto& th : threads) th.join();
+    int64_t t1 = now_us();
+
+    // 分块坐标平移到整帧坐标，再做全局 NMS 去掉重叠区域内的重复框
+    results.clear();
+    for(size_t i=0;i<tiles.size();i++){
+        for(auto r : tile_results[i]){
+            r.box.left += tiles[i].rect.x;
+            r.box.right += tiles[i].rect.x;
+            r.box.top += tiles[i].rect.y;
+            r.box.bottom += tiles[i].rect.y;
+            results.push_back(r);
+        }
+    }
+    nms_detect_results(results, cfg.nms_iou);
+    int64_t t2 = now_us();
+
+    int ret = 0;
+    stats.tiles = (int)tiles.size();
+    stats.crop_us = 0;
+    stats.infer_us = 0;
+    for(int w=0;w<workers;w++){
+        stats.crop_us += worker_crop_us[w];
+        stats.infer_us += worker_infer_us[w];
+        if(worker_ret[w] < 0) ret = -1;
+    }
+    stats.wall_us = t1 - t0;
+    stats.nms_us = t2 - t1;
+    return ret;
+}
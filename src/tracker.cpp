@@ -0,0 +1,223 @@
+#include "tracker.h"
+#include <math.h>
+#include <algorithm>
+
+// 过程噪声和测量噪声按框的高度缩放 (参考 ByteTrack 的 std_weight_position / std_weight_velocity)
+static const float STD_WEIGHT_POS = 1.0f / 20.0f;
+static const float STD_WEIGHT_VEL = 1.0f / 160.0f;
+
+void ObjectTracker::Kalman1D::init(float z, float std_pos, float std_vel){
+    x = z;
+    v = 0.0f;
+    p00 = std_pos * std_pos;
+    p01 = 0.0f;
+    p11 = std_vel * std_vel;
+}
+
+// x' = x + v, P' = F P F^T + Q
+void ObjectTracker::Kalman1D::predict(float q_pos, float q_vel){
+    x += v;
+    p00 += 2.0f * p01 + p11 + q_pos;
+    p01 += p11;
+    p11 += q_vel;
+}
+
+// 观测只有位置：H = [1 0]
+void ObjectTracker::Kalman1D::update(float z, float r){
+    float s = p00 + r;
+    float k0 = p00 / s;
+    float k1 = p01 / s;
+    float y = z - x;
+    x += k0 * y;
+    v += k1 * y;
+    float n00 = (1.0f - k0) * p00;
+    float n01 = (1.0f - k0) * p01;
+    float n11 = p11 - k1 * p01;
+    p00 = n00;
+    p01 = n01;
+    p11 = n11;
+}
+
+ObjectTracker::ObjectTracker(const TrackerConfig& cfg) : cfg(cfg), next_id(1) {
+}
+
+void ObjectTracker::reset(){
+    tracks.clear();
+}
+
+void ObjectTracker::init_track(Track& t, const DetectResult& det){
+    float w = det.box.right - det.box.left;
+    float h = det.box.bottom - det.box.top;
+    float z[4] = {det.box.left + w * 0.5f, det.box.top + h * 0.5f, w, h};
+    float std_pos = 2.0f * STD_WEIGHT_POS * h;
+    float std_vel = 10.0f * STD_WEIGHT_VEL * h;
+    for(int i=0;i<4;i++) t.kf[i].init(z[i], std_pos, std_vel);
+
+    t.id = next_id++;
+    t.class_id = det.id;
+    t.name = det.name;
+    t.confidence = det.confidence;
+    t.hits = 1;
+    t.lost = 0;
+    t.state = cfg.min_hits <= 1 ? TRACK_CONFIRMED : TRACK_TENTATIVE;
+    t.shown = true;
+}
+
+void ObjectTracker::update_track(Track& t, const DetectResult& det){
+    float w = det.box.right - det.box.left;
+    float h = det.box.bottom - det.box.top;
+    float z[4] = {det.box.left + w * 0.5f, det.box.top + h * 0.5f, w, h};
+    float std_meas = STD_WEIGHT_POS * std::max(h, 1.0f);
+    for(int i=0;i<4;i++) t.kf[i].update(z[i], std_meas * std_meas);
+
+    t.confidence = det.confidence;
+    t.hits++;
+    t.lost = 0;
+    t.shown = true;
+    if(t.state == TRACK_TENTATIVE && t.hits >= cfg.min_hits) t.state = TRACK_CONFIRMED;
+}
+
+void ObjectTracker::predict_tracks(){
+    for(auto& t : tracks){
+        float h = std::max(t.kf[3].x, 1.0f);
+        float q_pos = STD_WEIGHT_POS * h;
+        float q_vel = STD_WEIGHT_VEL * h;
+        for(int i=0;i<4;i++) t.kf[i].predict(q_pos * q_pos, q_vel * q_vel);
+        // 宽高不能预测成负数
+        if(t.kf[2].x < 1.0f) t.kf[2].x = 1.0f;
+        if(t.kf[3].x < 1.0f) t.kf[3].x = 1.0f;
+        t.lost++;
+    }
+}
+
+/**
+ * @brief  贪心 IoU 关联：按 IoU 从大到小依次配对，同类别且 IoU 不低于 match_iou 才能匹配
+ * @param  dets           全部检测框
+ * @param  det_idx        本轮参与关联的检测框下标
+ * @param  track_pool     本轮参与关联的轨迹下标，匹配上的会被移除
+ * @param  unmatched_dets 输出未匹配的检测框下标
+ * @param  det_track      按检测框下标记录匹配到的轨迹编号，-1 为未匹配
+**/
+void ObjectTracker::match(const std::vector<DetectResult>& dets, const std::vector<int>& det_idx,
+                          std::vector<int>& track_pool, std::vector<int>& unmatched_dets, std::vector<int>& det_track){
+    struct Pair { float iou; int t; int d; };
+    std::vector<Pair> pairs;
+    for(size_t ti=0;ti<track_pool.size();ti++){
+        const Track& t = tracks[track_pool[ti]];
+        DetectResult p = to_result(t);
+        for(int d : det_idx){
+            if(dets[d].id != t.class_id) continue;
+            float iou = detect_result_iou(p, dets[d]);
+            if(iou >= cfg.match_iou) pairs.push_back({iou, (int)ti, d});
+        }
+    }
+    std::sort(pairs.begin(), pairs.end(), [](const Pair& a, const Pair& b){ return a.iou > b.iou; });
+
+    std::vector<bool> track_used(track_pool.size(), false);
+    for(const auto& p : pairs){
+        if(track_used[p.t] || det_track[p.d] >= 0) continue;
+        track_used[p.t] = true;
+        Track& t = tracks[track_pool[p.t]];
+        det_track[p.d] = t.id;
+        update_track(t, dets[p.d]);
+    }
+
+    unmatched_dets.clear();
+    for(int d : det_idx){
+        if(det_track[d] < 0) unmatched_dets.push_back(d);
+    }
+    std::vector<int> remain;
+    for(size_t ti=0;ti<track_pool.size();ti++){
+        if(!track_used[ti]) remain.push_back(track_pool[ti]);
+    }
+    track_pool.swap(remain);
+}
+
+/**
+ * @brief  用一帧检测结果更新轨迹
+ * @param  dets 检测结果，框不变，track_id 填为关联上的已确认轨迹编号，否则为 -1
+**/
+void ObjectTracker::update(std::vector<DetectResult>& dets){
+    predict_tracks();
+    for(auto& t : tracks) t.shown = false;
+
+    std::vector<int> high, low;
+    for(size_t i=0;i<dets.size();i++){
+        if(dets[i].confidence >= cfg.high_thresh) high.push_back((int)i);
+        else if(dets[i].confidence >= cfg.low_thresh) low.push_back((int)i);
+    }
+
+    std::vector<int> track_pool;
+    for(size_t i=0;i<tracks.size();i++) track_pool.push_back((int)i);
+
+    std::vector<int> det_track(dets.size(), -1);
+    std::vector<int> unmatched_high, unmatched_low;
+    // 第一轮：高分检测框与全部轨迹关联
+    match(dets, high, track_pool, unmatched_high, det_track);
+    // 第二轮：低分检测框 (常见于遮挡、浑水) 只用来延续已确认的轨迹
+    std::vector<int> confirmed_pool;
+    for(int t : track_pool){
+        if(tracks[t].state == TRACK_CONFIRMED) confirmed_pool.push_back(t);
+    }
+    match(dets, low, confirmed_pool, unmatched_low, det_track);
+
+    // 未匹配的高分检测框新建轨迹
+    for(int d : unmatched_high){
+        Track t;
+        init_track(t, dets[d]);
+        det_track[d] = t.id;
+        tracks.push_back(t);
+    }
+
+    // 删除长时间未关联的轨迹，未确认的轨迹一旦丢失就删除
+    tracks.erase(std::remove_if(tracks.begin(), tracks.end(), [this](const Track& t){
+        return t.lost > cfg.max_lost || (t.state == TRACK_TENTATIVE && t.lost > 0);
+    }), tracks.end());
+
+    // 输出检测器的原始框，只有已确认的轨迹才给出编号
+    for(size_t i=0;i<dets.size();i++){
+        dets[i].track_id = -1;
+        if(det_track[i] < 0) continue;
+        for(const auto& t : tracks){
+            if(t.id == det_track[i]){
+                if(t.state == TRACK_CONFIRMED) dets[i].track_id = t.id;
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief  没有检测结果的帧：轨迹向前预测一帧
+ * @param  out 输出最近一次 update() 中关联到检测框的轨迹的预测框，未确认的轨迹 track_id 为 -1
+**/
+void ObjectTracker::predict(std::vector<DetectResult>& out){
+    predict_tracks();
+    tracks.erase(std::remove_if(tracks.begin(), tracks.end(), [this](const Track& t){
+        return t.lost > cfg.max_lost;
+    }), tracks.end());
+    emit(out);
+}
+
+DetectResult ObjectTracker::to_result(const Track& t){
+    DetectResult r;
+    r.id = t.class_id;
+    r.name = t.name;
+    r.confidence = t.confidence;
+    r.track_id = t.id;
+    r.box.left = (int)(t.kf[0].x - t.kf[2].x * 0.5f);
+    r.box.top = (int)(t.kf[1].x - t.kf[3].x * 0.5f);
+    r.box.right = (int)(t.kf[0].x + t.kf[2].x * 0.5f);
+    r.box.bottom = (int)(t.kf[1].x + t.kf[3].x * 0.5f);
+    return r;
+}
+
+// 输出最近一次 update() 中关联到检测框的轨迹的当前框，与 update() 的输出一致，未确认的轨迹不给编号
+void ObjectTracker::emit(std::vector<DetectResult>& out) const {
+    out.clear();
+    for(const auto& t : tracks){
+        if(!t.shown) continue;
+        out.push_back(to_result(t));
+        if(t.state != TRACK_CONFIRMED) out.back().track_id = -1;
+    }
+}
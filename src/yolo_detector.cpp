@@ -5,18 +5,20 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <algorithm>
+#include "count_utils.h"
 
-RKNNDetector::RKNNDetector():ctx(0), model_data(nullptr), model_data_size(0),
-                             input_attrs(nullptr), output_attrs(nullptr), model_path(""), width(640), 
-                             height(640), channel(3), img_width(0), img_height(0), nms_threshold(NMS_THRESH), 
-                             box_conf_threshold(BOX_THRESH) {
+RKNNDetector::RKNNDetector():ctx(0), model_file{nullptr, 0}, model_path(""),
+                             input_attrs(nullptr), output_attrs(nullptr), channel(3), width(640),
+                             height(640), img_width(0), img_height(0),
+                             core_mask(RKNN_NPU_CORE_AUTO), loading(false), replay(false) {
 }
 
 RKNNDetector::~RKNNDetector(){
-    if(model_data){
-        free(model_data);
-        model_data = nullptr;
-    }
+    if(loader.joinable()) loader.join();
+    staged.reset();
+    deinit_post_process(&pp_ctx);
+    unmap_model_file(&model_file);
     if(input_attrs){
         free(input_attrs);
         input_attrs = nullptr;
@@ -31,54 +33,26 @@ RKNNDetector::~RKNNDetector(){
     }
 }
 
-/**
- * @brief  从文件加载模型数据
- * @param  filename 模型文件的路径。
- * @param  model_size 指向整数的指针，用于存储模型的大小。
- * @return 指向加载的模型数据的指针，失败时返回nullptr。
- * @note   必须在不再使用这块数据时负责调用free(data) 否则会导致内存泄漏
-**/
-unsigned char* RKNNDetector::load_model_from_file(const char* filename, int* model_size){
-    FILE* fp = fopen(filename, "rb");
-    if(fp == nullptr){
-        printf("Failed to open model file: %s\n", filename);
-        return nullptr;
-    }
-    // 获取文件大小并读取数据
-    fseek(fp, 0, SEEK_END);
-    int size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-    unsigned char* data = (unsigned char*)malloc(size);
-    if(data == nullptr){
-        printf("Failed to allocate memory for model\n");
-        fclose(fp);
-        return nullptr;
-    }
-    fread(data, 1, size, fp);
-    fclose(fp);
-    *model_size = size;
-    return data;
-}
-
 /**
  * @brief  初始化RKNN检测器
  * @param  model_path 模型文件的路径。
+ * @param  label_path 类别名文件的路径，每行一个类别。
  * @return 初始化成功返回0，失败返回-1。
  * @remark 该函数加载模型数据，初始化RKNN上下文，并查询输入输出的数量和属性。
 **/
-int RKNNDetector::init(const std::string& model_path){
+int RKNNDetector::init(const std::string& model_path, const std::string& label_path){
     int ret;
 
     printf("Initializing RKNNDetector with model: %s...\n", model_path.c_str());
+    this->model_path = model_path;
     // 加载模型并初始化RKNN上下文
-    model_data = load_model_from_file(model_path.c_str(), &model_data_size);
-    if(model_data == nullptr) return -1;
+    // 模型文件直接映射，不再整文件拷贝一份
+    if(map_model_file(model_path.c_str(), &model_file) < 0) return -1;
 
-    ret = rknn_init(&ctx, model_data, model_data_size, 0, NULL);
+    ret = rknn_init(&ctx, model_file.data, model_file.size, 0, NULL);
     if(ret < 0){
         printf("rknn_init failed with error code: %d\n", ret);
-        free(model_data);
-        model_data = nullptr;
+        unmap_model_file(&model_file);
         return -1;
     }
 
@@ -98,8 +72,7 @@ int RKNNDetector::init(const std::string& model_path){
     ret = rknn_query(ctx, RKNN_QUERY_IN_OUT_NUM, &io_num, sizeof(io_num));
     if(ret < 0){
         printf("rknn_query RKNN_QUERY_IN_OUT_NUM failed with error code: %d\n", ret);
-        free(model_data);
-        model_data = nullptr;
+        unmap_model_file(&model_file);
         return -1;  
     }
     printf("Model has %d inputs and %d outputs\n", io_num.n_input, io_num.n_output);
@@ -108,8 +81,7 @@ int RKNNDetector::init(const std::string& model_path){
     output_attrs = (rknn_tensor_attr*)malloc(sizeof(rknn_tensor_attr) * io_num.n_output);
     if(input_attrs == nullptr || output_attrs == nullptr){
         printf("Failed to allocate memory for tensor attributes\n");
-        free(model_data);
-        model_data = nullptr;
+        unmap_model_file(&model_file);
         return -1;
     }
 
@@ -119,8 +91,7 @@ int RKNNDetector::init(const std::string& model_path){
         ret = rknn_query(ctx, RKNN_QUERY_INPUT_ATTR, &input_attrs[i], sizeof(rknn_tensor_attr));
         if(ret < 0){
             printf("rknn_query RKNN_QUERY_INPUT_ATTR failed with error code: %d\n", ret);
-            free(model_data);
-            model_data = nullptr;
+            unmap_model_file(&model_file);
             return -1;  
         }
     }
@@ -130,26 +101,140 @@ int RKNNDetector::init(const std::string& model_path){
         ret = rknn_query(ctx, RKNN_QUERY_OUTPUT_ATTR, &output_attrs[i], sizeof(rknn_tensor_attr));
         if(ret < 0){
             printf("rknn_query RKNN_QUERY_OUTPUT_ATTR failed with error code: %d\n", ret);
-            free(model_data);
-            model_data = nullptr;
+            unmap_model_file(&model_file);
             return -1;  
         }
     }
 
+    // 动态输入模型需要先设置一次输入尺寸才能推理，默认使用最大的一档
+    query_input_sizes();
+    if(is_dynamic() && apply_input_shape(input_sizes.back().width, input_sizes.back().height) < 0){
+        return -1;
+    }
+
     // 设置输出参数
+    printf("Model input format is %s\n", input_attrs[0].fmt == RKNN_TENSOR_NCHW ? "NCHW" : "NHWC");
+    update_input_dims();
+
+    // 根据输出属性选择解码器 (YOLOv5 anchor / YOLOv8 DFL，类别数)，并预计算查找表、加载标签
+    if(init_post_process(&pp_ctx, output_attrs, io_num.n_output, height, width, label_path.c_str()) < 0){
+        printf("Unsupported model outputs, n_output=%d\n", io_num.n_output);
+        return -1;
+    }
+
+    return 0;
+}
+
+// 从当前输入属性读取模型输入尺寸
+void RKNNDetector::update_input_dims(){
     if(input_attrs[0].fmt == RKNN_TENSOR_NCHW){
-        printf("Model input format is NCHW\n");
         width = input_attrs[0].dims[3];
         height = input_attrs[0].dims[2];
         channel = input_attrs[0].dims[1];
     }
     else{
-        printf("Model input format is NHWC\n");
         width = input_attrs[0].dims[2];
         height = input_attrs[0].dims[1];
         channel = input_attrs[0].dims[3];
     }
+}
 
+/**
+ * @brief  查询动态输入模型支持的输入尺寸，非动态模型 (只有一档尺寸) 时 input_sizes 为空
+**/
+void RKNNDetector::query_input_sizes(){
+    input_sizes.clear();
+    rknn_input_range range;
+    memset(&range, 0, sizeof(range));
+    range.index = 0;
+    if(rknn_query(ctx, RKNN_QUERY_INPUT_DYNAMIC_RANGE, &range, sizeof(range)) != RKNN_SUCC || range.shape_number <= 1){
+        return;
+    }
+    for(uint32_t i=0;i<range.shape_number;i++){
+        InputSize size;
+        if(range.fmt == RKNN_TENSOR_NCHW){
+            size.width = range.dyn_range[i][3];
+            size.height = range.dyn_range[i][2];
+        }
+        else{
+            size.width = range.dyn_range[i][2];
+            size.height = range.dyn_range[i][1];
+        }
+        input_sizes.push_back(size);
+    }
+    std::sort(input_sizes.begin(), input_sizes.end(), [](const InputSize& a, const InputSize& b){
+        return a.width * a.height < b.width * b.height;
+    });
+    printf("Dynamic input model, %d shapes:", (int)input_sizes.size());
+    for(const auto& sz : input_sizes) printf(" %dx%d", sz.width, sz.height);
+    printf("\n");
+}
+
+/**
+ * @brief  设置动态输入模型的输入尺寸，并刷新当前的输入输出属性
+ * @return 成功返回0，失败返回-1。
+**/
+int RKNNDetector::apply_input_shape(int input_width, int input_height){
+    std::vector<rknn_tensor_attr> attrs(input_attrs, input_attrs + io_num.n_input);
+    if(attrs[0].fmt == RKNN_TENSOR_NCHW){
+        attrs[0].dims[2] = input_height;
+        attrs[0].dims[3] = input_width;
+    }
+    else{
+        attrs[0].dims[1] = input_height;
+        attrs[0].dims[2] = input_width;
+    }
+    int ret = rknn_set_input_shapes(ctx, io_num.n_input, attrs.data());
+    if(ret < 0){
+        printf("rknn_set_input_shapes %dx%d failed with error code: %d\n", input_width, input_height, ret);
+        return -1;
+    }
+
+    for(int i=0;i<io_num.n_input;i++){
+        input_attrs[i].index = i;
+        ret = rknn_query(ctx, RKNN_QUERY_CURRENT_INPUT_ATTR, &input_attrs[i], sizeof(rknn_tensor_attr));
+        if(ret < 0){
+            printf("rknn_query RKNN_QUERY_CURRENT_INPUT_ATTR failed with error code: %d\n", ret);
+            return -1;
+        }
+    }
+    for(int i=0;i<io_num.n_output;i++){
+        output_attrs[i].index = i;
+        ret = rknn_query(ctx, RKNN_QUERY_CURRENT_OUTPUT_ATTR, &output_attrs[i], sizeof(rknn_tensor_attr));
+        if(ret < 0){
+            printf("rknn_query RKNN_QUERY_CURRENT_OUTPUT_ATTR failed with error code: %d\n", ret);
+            return -1;
+        }
+    }
+    update_input_dims();
+    return 0;
+}
+
+/**
+ * @brief  切换动态输入模型的输入尺寸
+ * @param  input_width  新的输入宽度，必须是 supported_input_sizes 中的一档
+ * @param  input_height 新的输入高度
+ * @return 成功返回0，失败返回-1 (失败时尺寸保持不变)。
+ * @remark 后处理的网格和步长随之更新；调用方需按新的 model_width/model_height 缩放输入图像。
+**/
+int RKNNDetector::set_input_size(int input_width, int input_height){
+    if(input_width == width && input_height == height) return 0;
+    bool supported = false;
+    for(const auto& sz : input_sizes){
+        if(sz.width == input_width && sz.height == input_height) supported = true;
+    }
+    if(!supported){
+        printf("Input size %dx%d is not supported by the model\n", input_width, input_height);
+        return -1;
+    }
+
+    int old_width = width, old_height = height;
+    if(apply_input_shape(input_width, input_height) < 0 ||
+       post_process_set_input_size(&pp_ctx, output_attrs, io_num.n_output, height, width) < 0){
+        apply_input_shape(old_width, old_height);
+        return -1;
+    }
+    printf("Model input size switched to %dx%d\n", width, height);
     return 0;
 }
 
@@ -157,6 +242,63 @@ rknn_context *RKNNDetector::get_ctx(){
     return &ctx;
 }
 
+/**
+ * @brief  设置关注的类别，解码时跳过其余类别通道，不关注的候选框不会进入 NMS
+ * @param  class_ids 关注的类别 id 列表，为空表示恢复全部类别
+ * @return 成功返回0，类别 id 越界返回-1。
+**/
+int RKNNDetector::set_class_filter(const std::vector<int>& class_ids){
+    return post_process_set_class_filter(&pp_ctx, class_ids);
+}
+
+/**
+ * @brief  设置单个类别的置信度阈值
+ * @param  class_id  类别 id
+ * @param  threshold 该类别的置信度阈值 (0~1)
+ * @return 成功返回0，参数非法返回-1。
+**/
+int RKNNDetector::set_class_threshold(int class_id, float threshold){
+    return post_process_set_class_threshold(&pp_ctx, class_id, threshold);
+}
+
+/**
+ * @brief  把推理绑定到指定的 NPU 核心
+ * @param  core_mask 核心掩码 (RKNN_NPU_CORE_0 / 1 / 2 / 0_1 / 0_1_2 / AUTO)
+ * @return 成功返回0，失败返回-1。
+ * @remark 多个实例分别绑定不同核心时可以真正并行推理。
+**/
+int RKNNDetector::set_core_mask(rknn_core_mask core_mask){
+    if(replay) return 0;
+    this->core_mask = core_mask;
+    int ret = rknn_set_core_mask(ctx, core_mask);
+    if(ret < 0){
+        printf("rknn_set_core_mask failed with error code: %d\n", ret);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief  设置全局置信度阈值 (默认 BOX_THRESH)
+ * @param  threshold 置信度阈值 (0~1)
+ * @return 成功返回0，参数非法返回-1。
+**/
+int RKNNDetector::set_conf_threshold(float threshold){
+    return post_process_set_conf_threshold(&pp_ctx, threshold);
+}
+
+/**
+ * @brief  设置检测框输出坐标系的尺寸
+ * @param  out_width  输出坐标系宽度
+ * @param  out_height 输出坐标系高度
+ * @remark 模型输入为 out_width x out_height 图像直接缩放得到时，检测框会被换算回该图像的坐标；
+ *         级联/分块等多个模型共用一套坐标时使用。
+**/
+void RKNNDetector::set_output_size(int out_width, int out_height){
+    img_width = out_width;
+    img_height = out_height;
+}
+
 /**
  * @brief  执行推理并获取检测结果
  * @param  img_data 输入图像数据，假设为RGB888格式。
@@ -168,6 +310,17 @@ rknn_context *RKNNDetector::get_ctx(){
 int RKNNDetector::inference(unsigned char* img_data, std::vector<DetectResult>& results){
     int ret;
 
+    // 后台加载好的新模型在两帧之间切换
+    if(loading) apply_staged_model();
+
+    if(replay){
+        // 回放模式：不调用 NPU，直接取录制的输出张量
+        int8_t* output_bufs[io_num.n_output];
+        if(replayer.next(output_bufs) < 0) return -1;
+        decode_outputs(output_bufs, results);
+        return 0;
+    }
+
     // 设置输入数据 （这里假设模型只有一个输入，且输入格式为NHWC，数据类型为UINT8）
     rknn_input inputs[1];
     memset(inputs, 0, sizeof(inputs));
@@ -178,11 +331,6 @@ int RKNNDetector::inference(unsigned char* img_data, std::vector<DetectResult>&
     inputs[0].pass_through = 0;
     inputs[0].size = input_attrs[0].n_elems * sizeof(uint8_t); // 输入数据大小 这里是INT8
 
-    float scale_w = 1.0f;
-    float scale_h = 1.0f;
-    BOX_RECT pads;
-    memset(&pads, 0, sizeof(BOX_RECT));
-    
     rknn_inputs_set(ctx, io_num.n_input, inputs);
 
     ret = rknn_run(ctx, nullptr);
@@ -205,39 +353,239 @@ int RKNNDetector::inference(unsigned char* img_data, std::vector<DetectResult>&
     }
 
     // 进行后处理，解析输出数据并填充results
-    detect_result_group_t detect_result_group;
-    std::vector<float> out_scales;
-    std::vector<int32_t> out_zps;
-    for(int i=0;i<io_num.n_output;i++)
-    {
-        out_scales.push_back(output_attrs[i].scale);
-        out_zps.push_back(output_attrs[i].zp);
+    int8_t* output_bufs[io_num.n_output];
+    for(int i=0;i<io_num.n_output;i++){
+        output_bufs[i] = (int8_t*)outputs[i].buf;
     }
-    // 检查输出向量维度是否符合预期，yolov5s模型通常有3个输出，分别对应不同尺度的检测结果
-    if(io_num.n_output < 3){
-        printf("Unexpected number of outputs: %d\n", io_num.n_output);
-        rknn_outputs_release(ctx, io_num.n_output, outputs); // 释放之前的输出数据
-        return -1;
+    if(recorder.is_open()){
+        recorder.write(output_bufs);
     }
 
-    post_process((int8_t*)outputs[0].buf, (int8_t*)outputs[1].buf, (int8_t*)outputs[2].buf, height, width,
-                  box_conf_threshold, nms_threshold, pads, scale_w, scale_h, out_zps, out_scales, &detect_result_group);
+    decode_outputs(output_bufs, results);
+
+    rknn_outputs_release(ctx, io_num.n_output, outputs); // 释放之前的输出数据
+
+    return 0;
+}
+
+/**
+ * @brief  对一帧原始输出做后处理并转换为 DetectResult
+ * @param  output_bufs 每个输出的 int8 数据指针
+ * @param  results     输出检测结果的向量。
+**/
+void RKNNDetector::decode_outputs(int8_t** output_bufs, std::vector<DetectResult>& results){
+    float scale_w = img_width > 0 ? (float)width / img_width : 1.0f;
+    float scale_h = img_height > 0 ? (float)height / img_height : 1.0f;
+    BOX_RECT pads;
+    memset(&pads, 0, sizeof(BOX_RECT));
+
+    // 低置信度结果已在后处理中按 (类别) 阈值过滤
+    detect_result_group_t detect_result_group;
+    post_process(&pp_ctx, output_bufs, height, width, pads, scale_w, scale_h, &detect_result_group,
+                 is_segmentation() ? &masks : nullptr);
 
     results.clear();
     for(int i=0;i<detect_result_group.count;i++){
-        if(detect_result_group.results[i].prop < box_conf_threshold) continue; // 过滤低置信度结果
         DetectResult res;
         res.id = detect_result_group.results[i].class_index;
         res.name = detect_result_group.results[i].name;
         res.confidence = detect_result_group.results[i].prop;
+        res.track_id = -1;
         res.box.left = detect_result_group.results[i].box.left;
         res.box.top = detect_result_group.results[i].box.top;
         res.box.right = detect_result_group.results[i].box.right;
         res.box.bottom = detect_result_group.results[i].box.bottom;
         results.push_back(res);
     }
-    
-    rknn_outputs_release(ctx, io_num.n_output, outputs); // 释放之前的输出数据
+}
+
+/**
+ * @brief  开启输出张量录制，之后每次 inference 都会把原始 int8 输出写入目录
+ * @param  dir        录制目录
+ * @param  max_frames 最多录制的帧数，0 表示不限
+ * @return 成功返回0，失败返回-1。
+ * @remark 需在 init 之后调用，录制结果可用 init_replay 或 postprocess_bench 回放。
+**/
+int RKNNDetector::set_capture(const std::string& dir, int max_frames){
+    if(output_attrs == nullptr){
+        printf("set_capture must be called after init\n");
+        return -1;
+    }
+    return recorder.open(dir, output_attrs, io_num.n_output, width, height, max_frames);
+}
+
+/**
+ * @brief  以回放模式初始化：不加载模型，inference 循环返回录制帧的后处理结果
+ * @param  capture_dir 录制目录 (set_capture 的输出)
+ * @param  label_path  类别名文件的路径
+ * @return 成功返回0，失败返回-1。
+**/
+int RKNNDetector::init_replay(const std::string& capture_dir, const std::string& label_path){
+    if(replayer.open(capture_dir) < 0) return -1;
+
+    io_num.n_input = 0;
+    io_num.n_output = replayer.output_count();
+    output_attrs = (rknn_tensor_attr*)malloc(sizeof(rknn_tensor_attr) * io_num.n_output);
+    if(output_attrs == nullptr){
+        printf("Failed to allocate memory for tensor attributes\n");
+        return -1;
+    }
+    memcpy(output_attrs, replayer.output_attrs(), sizeof(rknn_tensor_attr) * io_num.n_output);
+    width = replayer.model_width();
+    height = replayer.model_height();
 
+    if(init_post_process(&pp_ctx, output_attrs, io_num.n_output, height, width, label_path.c_str()) < 0){
+        printf("Unsupported model outputs, n_output=%d\n", io_num.n_output);
+        return -1;
+    }
+    replay = true;
+    return 0;
+}
+
+float detect_result_iou(const DetectResult& a, const DetectResult& b){
+    float iw = std::min(a.box.right, b.box.right) - std::max(a.box.left, b.box.left);
+    float ih = std::min(a.box.bottom, b.box.bottom) - std::max(a.box.top, b.box.top);
+    if(iw <= 0 || ih <= 0) return 0.0f;
+    float inter = iw * ih;
+    float area_a = (float)(a.box.right - a.box.left) * (a.box.bottom - a.box.top);
+    float area_b = (float)(b.box.right - b.box.left) * (b.box.bottom - b.box.top);
+    float uni = area_a + area_b - inter;
+    return uni <= 0 ? 0.0f : inter / uni;
+}
+
+/**
+ * @brief  对多个来源 (多个模型、多个分块) 合并后的检测框做按类别的 NMS
+ * @param  dets       检测框，原地删除被抑制的框，结果按置信度从高到低排列
+ * @param  iou_thresh IoU 阈值
+**/
+void nms_detect_results(std::vector<DetectResult>& dets, float iou_thresh){
+    std::stable_sort(dets.begin(), dets.end(), [](const DetectResult& a, const DetectResult& b){
+        return a.confidence > b.confidence;
+    });
+    std::vector<DetectResult> keep;
+    keep.reserve(dets.size());
+    for(const auto& d : dets){
+        bool suppressed = false;
+        for(const auto& k : keep){
+            if(k.id == d.id && detect_result_iou(k, d) > iou_thresh){
+                suppressed = true;
+                break;
+            }
+        }
+        if(!suppressed) keep.push_back(d);
+    }
+    dets.swap(keep);
+}
+
+/**
+ * @brief  后台加载新模型
+ * @param  model_path 新模型文件的路径
+ * @param  label_path 类别名文件的路径
+ * @return 已开始加载返回0，已有模型在加载中或处于回放模式返回-1。
+ * @remark 新模型沿用当前实例的核心绑定；类别数不变时沿用类别过滤和阈值设置。
+ *         新模型的输入尺寸和通道数必须与当前一致 (动态输入模型需支持当前尺寸)，否则放弃切换，
+ *         调用方的输入缓冲区按当前尺寸分配，尺寸变大会读越界。
+**/
+int RKNNDetector::load_model_async(const std::string& model_path, const std::string& label_path){
+    if(replay || ctx == 0){
+        printf("load_model_async requires an initialized NPU detector\n");
+        return -1;
+    }
+    bool expected = false;
+    if(!loading.compare_exchange_strong(expected, true)){
+        printf("Model swap already in progress\n");
+        return -1;
+    }
+    if(loader.joinable()) loader.join();
+    // 当前输入尺寸在调用线程 (推理线程) 上取，后台线程不读 width/height
+    loader = std::thread(&RKNNDetector::load_worker, this, model_path, label_path, width, height, channel);
     return 0;
 }
+
+/**
+ * @brief  检查新模型的输入是否与当前一致，动态输入模型先切换到当前尺寸
+ * @return 一致返回0，不一致返回-1
+**/
+int RKNNDetector::match_input(RKNNDetector& next, int want_width, int want_height, int want_channel){
+    if(next.channel != want_channel) return -1;
+    if(next.width == want_width && next.height == want_height) return 0;
+    return next.is_dynamic() ? next.set_input_size(want_width, want_height) : -1;
+}
+
+// 后台线程：完整初始化一个新的检测器实例并做一次预热推理，完成后放入 staged 等待切换
+void RKNNDetector::load_worker(std::string model_path, std::string label_path, int want_width, int want_height, int want_channel){
+    int64_t t0 = now_us();
+    std::unique_ptr<RKNNDetector> next(new RKNNDetector());
+    if(next->init(model_path, label_path) < 0){
+        printf("Model swap: failed to load %s, keep %s\n", model_path.c_str(), this->model_path.c_str());
+        loading = false;
+        return;
+    }
+    if(match_input(*next, want_width, want_height, want_channel) < 0){
+        printf("Model swap: %s input %dx%dx%d does not match current %dx%dx%d, rejected\n", model_path.c_str(),
+               next->width, next->height, next->channel, want_width, want_height, want_channel);
+        loading = false;
+        return;
+    }
+    if(core_mask != RKNN_NPU_CORE_AUTO) next->set_core_mask(core_mask);
+
+    // 预热：第一次 rknn_run 会分配内部内存、加载权重，放在后台做，切换后的第一帧不会变慢
+    std::vector<unsigned char> dummy((size_t)next->width * next->height * next->channel, 0);
+    std::vector<DetectResult> dummy_results;
+    next->inference(dummy.data(), dummy_results);
+
+    std::lock_guard<std::mutex> lk(swap_mtx);
+    staged = std::move(next);
+    printf("Model swap: %s ready in %.1f ms\n", model_path.c_str(), (now_us() - t0) / 1000.0);
+}
+
+/**
+ * @brief  在两帧之间切换到后台加载好的模型，旧模型交给后台线程释放
+**/
+void RKNNDetector::apply_staged_model(){
+    std::unique_ptr<RKNNDetector> old;
+    {
+        std::unique_lock<std::mutex> lk(swap_mtx, std::try_to_lock);
+        if(!lk.owns_lock() || !staged) return;
+        old = std::move(staged);
+    }
+    // 加载期间当前模型可能切换过输入尺寸 (动态输入)，切换前再确认一次
+    if(match_input(*old, width, height, channel) < 0){
+        printf("Model swap: %s cannot use the current input %dx%d, rejected\n", old->model_path.c_str(), width, height);
+        loading = false;
+        RKNNDetector* rejected = old.release();
+        std::thread([rejected]() { delete rejected; }).detach();
+        return;
+    }
+    swap_model(*old);
+    loading = false;
+    printf("Model swap: switched to %s\n", model_path.c_str());
+
+    // rknn_destroy 和释放模型内存可能耗时数十毫秒，不放在推理线程上做
+    RKNNDetector* retired = old.release();
+    std::thread([retired]() { delete retired; }).detach();
+}
+
+// 交换两个实例的模型相关状态，输出坐标系、录制和热切换状态保留在原实例
+void RKNNDetector::swap_model(RKNNDetector& other){
+    // 类别数不变时沿用当前的阈值与类别过滤设置
+    if(other.pp_ctx.head.class_num == pp_ctx.head.class_num){
+        other.pp_ctx.conf_threshold = pp_ctx.conf_threshold;
+        other.pp_ctx.nms_threshold = pp_ctx.nms_threshold;
+        other.pp_ctx.filter = pp_ctx.filter;
+        other.pp_ctx.use_filter = pp_ctx.use_filter;
+        other.pp_ctx.gate_threshold = pp_ctx.gate_threshold;
+    }
+    std::swap(ctx, other.ctx);
+    std::swap(model_file, other.model_file);
+    std::swap(model_path, other.model_path);
+    std::swap(io_num, other.io_num);
+    std::swap(input_attrs, other.input_attrs);
+    std::swap(output_attrs, other.output_attrs);
+    std::swap(pp_ctx, other.pp_ctx);
+    std::swap(channel, other.channel);
+    std::swap(width, other.width);
+    std::swap(height, other.height);
+    std::swap(input_sizes, other.input_sizes);
+    masks.clear();
+}
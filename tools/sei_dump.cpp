@@ -0,0 +1,72 @@
+/*
+    检测结果 SEI 参考解析工具：从 H.264 / H.265 Annex B 码流中取出每帧的检测结果 SEI 并打印，
+    接收端可以参照 src/det_sei.cpp 的解析代码自行绘制检测框。不依赖 MPP/RGA/NPU，可以在 PC 上编译运行。
+
+    用法:
+      sei_dump <file.h264>
+      ffmpeg -i udp://0.0.0.0:8888 -c copy -f h264 - | sei_dump -
+      ffmpeg -i rtsp://<ip>:8554/live -c copy -f hevc - | sei_dump -      (H.265)
+*/
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "det_sei.h"
+
+static void print_sei(const DetectionSei& sei){
+    printf("frame %u ts=%llu us dets=%zu\n", sei.frame_id, (unsigned long long)sei.timestamp_us, sei.dets.size());
+    for(const auto& d : sei.dets){
+        printf("  cls=%d track=%d conf=%.3f box=(%d, %d, %d, %d)\n", d.class_id, d.track_id, d.confidence,
+               d.left, d.top, d.right, d.bottom);
+    }
+}
+
+// 在 [from, len) 中查找起始码 00 00 01，返回其位置，没有返回 len
+static size_t find_start_code(const std::vector<uint8_t>& buf, size_t from){
+    for(size_t i=from;i+2<buf.size();i++){
+        if(buf[i] == 0x00 && buf[i + 1] == 0x00 && buf[i + 2] == 0x01) return i;
+    }
+    return buf.size();
+}
+
+int main(int argc, char* argv[]){
+    if(argc != 2){
+        printf("usage: %s <file.h264 | file.h265 | ->\n", argv[0]);
+        return 1;
+    }
+    FILE* fp = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "rb");
+    if(fp == nullptr){
+        perror("open input failed");
+        return 1;
+    }
+
+    // 流式处理：缓冲区中两个起始码之间是一个完整的 NAL，最后一个 NAL 留到读入更多数据后再处理
+    std::vector<uint8_t> buf;
+    uint8_t chunk[64 * 1024];
+    int found = 0;
+    bool eof = false;
+    while(!eof){
+        size_t n = fread(chunk, 1, sizeof(chunk), fp);
+        if(n == 0) eof = true;
+        buf.insert(buf.end(), chunk, chunk + n);
+
+        size_t pos = find_start_code(buf, 0);
+        while(pos < buf.size()){
+            size_t next = find_start_code(buf, pos + 3);
+            if(next >= buf.size() && !eof) break;
+            DetectionSei sei;
+            if(parse_detection_sei(buf.data() + pos + 3, next - pos - 3, sei) == 0){
+                print_sei(sei);
+                found++;
+            }
+            pos = next;
+        }
+        buf.erase(buf.begin(), buf.begin() + std::min(pos, buf.size()));
+    }
+
+    if(fp != stdin) fclose(fp);
+    printf("%d detection SEI found\n", found);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "model_file.h"
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ *   @brief   映射模型文件
+ *   @param   path  模型文件路径
+ *   @param   file  输出参数，成功时包含映射地址和文件大小
+ *   @return  0 成功，-1 失败
+ *   @remark  页面由内核按需从页缓存读入，不额外拷贝一份；rknn_init 顺序读取整个模型，
+ *            用 MADV_SEQUENTIAL | MADV_WILLNEED 提示内核提前预读。
+**/
+int map_model_file(const char *path, struct MappedFile *file) {
+    if (!file) {
+        return -1;
+    }
+    file->data = NULL;
+    file->size = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Failed to open model file: %s\n", path);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size <= 0) {
+        printf("Invalid model file: %s\n", path);
+        close(fd);
+        return -1;
+    }
+
+    // 私有可写映射：rknn_init 的参数不是 const，即使写入也只触发写时复制，不会改动文件
+    void *data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("mmap model file failed");
+        return -1;
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    madvise(data, st.st_size, MADV_WILLNEED);
+
+    file->data = data;
+    file->size = st.st_size;
+    return 0;
+}
+
+/**
+ *   @brief   解除模型文件映射
+ *   @param   file  需要解除映射的结构体
+**/
+void unmap_model_file(struct MappedFile *file) {
+    if (file && file->data) {
+        munmap(file->data, file->size);
+        file->data = NULL;
+        file->size = 0;
+    }
+}
@@ -1,5 +1,7 @@
 #include "../inc/udp_utils.h"
 #include <stdio.h>
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
 
 /** 
  * @brief   初始化UDP上下文，创建UDP socket并设置目标地址
@@ -24,6 +26,20 @@ int udp_init(UdpContext *ctx, const char *dest_ip, int port){
     if (setsockopt(ctx->socket_fd, SOL_SOCKET, SO_SNDBUF, &sock_buf_size, sizeof(sock_buf_size)) < 0) {
         perror("设置发送缓冲区失败");
     }
+    // 内核会把设置值翻倍，读回实际大小用于计算队列占用率
+    socklen_t opt_len = sizeof(ctx->sndbuf);
+    if (getsockopt(ctx->socket_fd, SOL_SOCKET, SO_SNDBUF, &ctx->sndbuf, &opt_len) < 0) {
+        ctx->sndbuf = sock_buf_size;
+    }
+    ctx->send_failures = 0;
+
+    // 链路拥塞时 sendto 不无限阻塞，超时返回错误
+    struct timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = UDP_SEND_TIMEOUT_MS * 1000;
+    if (setsockopt(ctx->socket_fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) < 0) {
+        perror("设置发送超时失败");
+    }
 
     return 0;
 }
@@ -33,19 +49,83 @@ int udp_init(UdpContext *ctx, const char *dest_ip, int port){
  * @param   ctx     UDP上下文结构体指针
  * @param   data    待发送数据指针
  * @param   len     待发送数据长度
- * @return  无返回值
+ * @return  0 成功，-1 发送失败 (发送缓冲区满超时或网络错误)，失败时放弃剩余的分片
  * @remark  该函数会将输入数据分成多个小块（每块不超过UDP_MTU），并通过UDP socket发送到目标地址。调用者无需关心分片细节，直接调用此函数即可发送任意大小的数据。
  *          注意：UDP协议不保证数据包的可靠送达和顺序，因此在网络状况不佳时可能会丢包或乱序。调用者需要根据实际需求考虑是否需要在应用层实现重传机制或使用更可靠的传输协议。
  *          该函数适用于发送编码后的H.264帧数据，尤其是I帧等较大的数据块，可以有效避免IP层的分片，提高传输效率和成功率。
 **/
-void udp_send(UdpContext *ctx, void *data, size_t len){
+int udp_send(UdpContext *ctx, void *data, size_t len){
      uint8_t *send_ptr = (uint8_t*)data;
      size_t remain = len;
 
      while(remain > 0){
          size_t chunk = (remain > UDP_MTU) ? UDP_MTU : remain;
-         sendto(ctx->socket_fd, send_ptr, chunk, 0 , (struct sockaddr *)&ctx->dest_addr, sizeof(ctx->dest_addr));
+         if(sendto(ctx->socket_fd, send_ptr, chunk, 0 , (struct sockaddr *)&ctx->dest_addr, sizeof(ctx->dest_addr)) < 0){
+             // 这一帧已经不完整，剩余分片不再发送，把带宽留给后面的帧
+             ctx->send_failures++;
+             return -1;
+         }
          send_ptr += chunk;
          remain -= chunk;
      }
-}
\ No newline at end of file
+     return 0;
+}
+
+#define UDP_MAX_IOV 16  // 一个分片最多由多少段内存拼成
+
+/** 
+ * @brief   通过UDP发送分散在多段内存中的数据，分片方式与 udp_send 相同
+ * @param   ctx     UDP上下文结构体指针
+ * @param   iov     数据段数组，按顺序拼接为一条完整的数据
+ * @param   iovcnt  数据段个数
+ * @return  0 成功，-1 发送失败，失败时与 udp_send 一样放弃剩余的分片
+ * @remark  每个分片用 sendmsg 直接从各段内存聚合发送 (分片可以跨越数据段)，不需要先拼接到连续的缓冲区。
+ *          接收端看到的分片与对拼接后的数据调用 udp_send 完全一致。
+**/
+int udp_sendv(UdpContext *ctx, const struct iovec *iov, int iovcnt){
+    struct iovec parts[UDP_MAX_IOV];
+    struct msghdr msg;
+    int idx = 0;
+    size_t offset = 0;  // 当前数据段中已发送的字节数
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &ctx->dest_addr;
+    msg.msg_namelen = sizeof(ctx->dest_addr);
+    msg.msg_iov = parts;
+
+    while(idx < iovcnt){
+        size_t chunk = 0;
+        int n = 0;
+        // 从当前位置开始凑满一个分片
+        while(idx < iovcnt && chunk < UDP_MTU && n < UDP_MAX_IOV){
+            size_t avail = iov[idx].iov_len - offset;
+            size_t take = (avail > UDP_MTU - chunk) ? UDP_MTU - chunk : avail;
+            if(take > 0){
+                parts[n].iov_base = (uint8_t*)iov[idx].iov_base + offset;
+                parts[n].iov_len = take;
+                n++;
+                chunk += take;
+                offset += take;
+            }
+            if(offset >= iov[idx].iov_len){
+                idx++;
+                offset = 0;
+            }
+        }
+        if(n == 0) break;
+        msg.msg_iovlen = n;
+        if(sendmsg(ctx->socket_fd, &msg, 0) < 0){
+            ctx->send_failures++;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int udp_queued_bytes(UdpContext *ctx){
+    int queued = 0;
+    if(ioctl(ctx->socket_fd, SIOCOUTQ, &queued) < 0){
+        return -1;
+    }
+    return queued;
+}